@@ -20,8 +20,8 @@ void setup() {
   Serial.begin(9600);
   pinMode(LEDPIN, OUTPUT);
 
-  // 初始化
-  while (fpm.getChipSN() == "") {
+  // 初始化：探测模组波特率并读取指纹库容量等参数
+  while (!fpm.begin()) {
     Serial.println("等待......");
     delay(200);  //等待指纹识别模块初始化完成
   }
@@ -0,0 +1,59 @@
+/*
+  指纹识别模块测试程序
+  异步（非阻塞）识别指纹：beginIdentify() 开始识别，poll() 推进，识别过程中 loop() 可同时处理其他任务
+
+  更多指令集请参见：http://file.yfrobot.com.cn/datasheet/FPM383C%E6%A8%A1%E7%BB%84%E9%80%9A%E4%BF%A1%E5%8D%8F%E8%AE%AE_V1.2.pdf
+
+  Author     : YFROBOT ZL
+  Website    : www.yfrobot.com.cn
+  update Time: 2024-04-11
+*/
+
+#include "yfrobot_fpm383.h"
+
+YFROBOTFPM383 fpm(9, 8);  //软串口引脚，RX：D9    TX：D8
+int LEDPIN = 13;
+unsigned long lastStart = 0;
+unsigned long lastBlink = 0;
+
+// 识别完成回调，result 含义与 identify() 返回值相同
+void onFingerprint(YFROBOTFPM383 *sensor, uint8_t op, uint8_t result) {
+  if (op != FPM383_OP_IDENTIFY) return;
+  if (result == 0xFE) {
+    Serial.println("未认证指纹");
+  } else if (result != 0xFF) {
+    Serial.print("识别到指纹");
+    Serial.println(result);
+  }
+}
+
+void setup() {
+  // put your setup code here, to run once:
+  Serial.begin(9600);
+  pinMode(LEDPIN, OUTPUT);
+
+  // 初始化：探测模组波特率并读取指纹库容量等参数
+  while (!fpm.begin()) {
+    Serial.println("等待......");
+    delay(200);  //等待指纹识别模块初始化完成
+  }
+  Serial.println(fpm.getChipSN());
+  fpm.onComplete(onFingerprint);
+
+  Serial.println("开始");
+}
+
+void loop() {
+  // put your main code here, to run repeatedly:
+  fpm.poll();  // 推进识别，不阻塞
+  if (!fpm.busy() && millis() - lastStart > 500) {  // 推荐>500ms
+    lastStart = millis();
+    fpm.beginIdentify(false);
+  }
+
+  // 识别过程中其他任务照常运行
+  if (millis() - lastBlink > 250) {
+    lastBlink = millis();
+    digitalWrite(LEDPIN, !digitalRead(LEDPIN));
+  }
+}
@@ -0,0 +1,63 @@
+/*
+  指纹识别模块测试程序
+  读取指纹库索引表，自动在第一个空闲ID注册指纹，并列出所有已注册ID
+
+  更多指令集请参见：http://file.yfrobot.com.cn/datasheet/FPM383C%E6%A8%A1%E7%BB%84%E9%80%9A%E4%BF%A1%E5%8D%8F%E8%AE%AE_V1.2.pdf
+
+  Author     : YFROBOT ZL
+  Website    : www.yfrobot.com.cn
+  update Time: 2024-04-11
+*/
+
+#include "yfrobot_fpm383.h"
+
+YFROBOTFPM383 fpm(9, 8);  //软串口引脚，RX：D9    TX：D8
+
+void printEnrolled() {
+  Serial.print("已注册ID：");
+  for (uint16_t id = fpm.nextEnrolled(0); id != FPM383_NO_ID; id = fpm.nextEnrolled(id + 1)) {
+    Serial.print(id);
+    Serial.print(" ");
+  }
+  Serial.println();
+}
+
+void setup() {
+  // put your setup code here, to run once:
+  Serial.begin(9600);
+
+  // 初始化：探测模组波特率并读取指纹库容量等参数
+  while (!fpm.begin()) {
+    Serial.println("等待......");
+    delay(200);  //等待指纹识别模块初始化完成
+  }
+  Serial.println(fpm.getChipSN());
+
+  // 读取一次索引表，之后注册、删除、清空时自动更新
+  while (!fpm.loadIndex()) {
+    delay(200);
+  }
+  printEnrolled();
+
+  Serial.println("开始");
+}
+
+void loop() {
+  // put your main code here, to run repeatedly:
+  uint16_t id = fpm.nextFreeId();
+  if (id == FPM383_NO_ID) {
+    Serial.println("指纹库已满！");
+    while (1);
+  }
+  if (id == FPM383_ID_UNTRACKED) {  // 模组容量大于位图，需用全局编译选项增大 FPM383_MAX_IDS
+    Serial.println("位图内的ID已满，之后的ID未跟踪！");
+    while (1);
+  }
+  Serial.print("注册指纹，在ID:");
+  Serial.print(id);
+  Serial.println("位置，请将手指按压在模块上4次！");
+  if (fpm.enroll(id, 4) == 0x00) {
+    printEnrolled();
+  }
+  delay(1000);
+}
@@ -0,0 +1,73 @@
+/*
+  指纹识别模块测试程序
+  带进度的注册：onEnrollProgress() 设置回调后，模组在每次采集、合并、存储时返回状态，
+  可用于显示注册进度；某次采集失败（如手指按压不完整）时回调返回 false 立即取消，无需等待超时
+
+  更多指令集请参见：http://file.yfrobot.com.cn/datasheet/FPM383C%E6%A8%A1%E7%BB%84%E9%80%9A%E4%BF%A1%E5%8D%8F%E8%AE%AE_V1.2.pdf
+
+  Author     : YFROBOT ZL
+  Website    : www.yfrobot.com.cn
+  update Time: 2024-04-11
+*/
+
+#include "yfrobot_fpm383.h"
+
+YFROBOTFPM383 fpm(9, 8);  //软串口引脚，RX：D9    TX：D8
+int ENROLLID = 1;         // 注册ID
+int ENTRIES = 4;          // 采集次数
+
+// 注册进度回调：stage 为步骤，index 为第几次采集，code 非0表示该次采集失败
+bool onProgress(YFROBOTFPM383 *sensor, uint8_t stage, uint8_t index, uint8_t code) {
+  if (code != 0x00) {
+    Serial.println("采集失败，取消注册");
+    return false;
+  }
+  switch (stage) {
+    case FPM383_ENROLL_CHAR:
+      Serial.print("第");
+      Serial.print(index);
+      Serial.print("/");
+      Serial.print(ENTRIES);
+      Serial.println("次采集完成");
+      break;
+    case FPM383_ENROLL_LEAVE:
+      Serial.println("请抬起手指后再次按下");
+      break;
+    case FPM383_ENROLL_MERGE:
+      Serial.println("合并模板");
+      break;
+    case FPM383_ENROLL_STORE:
+      Serial.println("存储模板");
+      break;
+  }
+  return true;
+}
+
+void setup() {
+  // put your setup code here, to run once:
+  Serial.begin(9600);
+
+  // 初始化：探测模组波特率并读取指纹库容量等参数
+  while (!fpm.begin()) {
+    Serial.println("等待......");
+    delay(200);  //等待指纹识别模块初始化完成
+  }
+  Serial.println(fpm.getChipSN());
+  fpm.onEnrollProgress(onProgress);
+
+  Serial.println("请按下手指");
+  uint8_t result = fpm.enroll(ENROLLID, ENTRIES);
+  if (result == 0x00) {
+    Serial.println("注册成功");
+  } else if (result == 0x01) {
+    Serial.println("该ID已注册");
+  } else if (result == FPM383_RESULT_CANCELLED) {
+    Serial.println("已取消");
+  } else {
+    Serial.println("注册失败");
+  }
+}
+
+void loop() {
+  // put your main code here, to run repeatedly:
+}
@@ -0,0 +1,53 @@
+/*
+  指纹识别模块测试程序
+  触摸唤醒低功耗识别：模组休眠等待触摸，TOUCHOUT 引脚上升沿（手指按下）触发自动验证，完成后再次休眠。
+  等待期间不发送任何指令，手指按下后立即开始识别，比每秒轮询 identify() 功耗更低、响应更快
+
+  接线：模组 TOUCHOUT 接 D2（UNO 外部中断0）；不支持外部中断的引脚在 poll() 中查询电平，同样可用
+
+  更多指令集请参见：http://file.yfrobot.com.cn/datasheet/FPM383C%E6%A8%A1%E7%BB%84%E9%80%9A%E4%BF%A1%E5%8D%8F%E8%AE%AE_V1.2.pdf
+
+  Author     : YFROBOT ZL
+  Website    : www.yfrobot.com.cn
+  update Time: 2024-04-11
+*/
+
+#include "yfrobot_fpm383.h"
+
+YFROBOTFPM383 fpm(9, 8);  //软串口引脚，RX：D9    TX：D8
+int TOUCHPIN = 2;         // TOUCHOUT 引脚
+
+// 识别完成回调，result 含义与 autoIdentify() 返回值相同
+void onFingerprint(YFROBOTFPM383 *sensor, uint8_t op, uint8_t result) {
+  if (op != FPM383_OP_AUTO_IDENTIFY) return;
+  if (result == 0xFE) {
+    Serial.println("未认证指纹");
+  } else if (result != 0xFF) {
+    Serial.print("识别到指纹");
+    Serial.println(result);
+  }
+}
+
+void setup() {
+  // put your setup code here, to run once:
+  Serial.begin(9600);
+
+  // 初始化：探测模组波特率并读取指纹库容量等参数
+  while (!fpm.begin()) {
+    Serial.println("等待......");
+    delay(200);  //等待指纹识别模块初始化完成
+  }
+  Serial.println(fpm.getChipSN());
+  fpm.onComplete(onFingerprint);
+
+  if (!fpm.touchBegin(TOUCHPIN)) {
+    Serial.println("该引脚不支持外部中断，使用查询模式");
+  }
+  fpm.beginTouchIdentify(false);
+  Serial.println("请按下手指");
+}
+
+void loop() {
+  // put your main code here, to run repeatedly:
+  fpm.poll();  // 休眠等待触摸时只读取标志，不收发数据
+}
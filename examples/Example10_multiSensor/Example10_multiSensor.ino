@@ -0,0 +1,53 @@
+/*
+  指纹识别模块测试程序
+  多模组识别：入口、出口各一个模组，分别接在两个硬件串口上，调度器轮流推进两个模组的异步识别，
+  两个模组的串口收发交错进行，互不等待
+
+  接线（ESP32）：入口模组 RX：25  TX：26（Serial1）；出口模组 RX：16  TX：17（Serial2）
+  Arduino MEGA 使用 Serial1、Serial2 默认引脚，引脚参数被忽略
+
+  更多指令集请参见：http://file.yfrobot.com.cn/datasheet/FPM383C%E6%A8%A1%E7%BB%84%E9%80%9A%E4%BF%A1%E5%8D%8F%E8%AE%AE_V1.2.pdf
+
+  Author     : YFROBOT ZL
+  Website    : www.yfrobot.com.cn
+  update Time: 2024-04-11
+*/
+
+#include "yfrobot_fpm383.h"
+#include "fpm383_scheduler.h"
+
+YFROBOTFPM383 entry(Serial1, 25, 26);  // 入口模组
+YFROBOTFPM383 exitGate(Serial2, 16, 17);  // 出口模组
+FPM383Scheduler scheduler;
+
+// 识别完成回调，fpm 指明是哪个模组，result 含义与 identify() 返回值相同
+void onFingerprint(YFROBOTFPM383 *fpm, uint8_t op, uint8_t result) {
+  if (op != FPM383_OP_IDENTIFY || result == 0xFF) return;  // 无手指
+  Serial.print(fpm == &entry ? "入口：" : "出口：");
+  if (result == 0xFE) {
+    Serial.println("未认证指纹");
+  } else {
+    Serial.print("识别到指纹");
+    Serial.println(result);
+  }
+}
+
+void setup() {
+  // put your setup code here, to run once:
+  Serial.begin(9600);
+
+  // 初始化：探测模组波特率并读取指纹库容量等参数
+  while (!entry.begin() || !exitGate.begin()) {
+    Serial.println("等待......");
+    delay(200);  //等待指纹识别模块初始化完成
+  }
+  scheduler.add(entry);
+  scheduler.add(exitGate);
+  scheduler.onComplete(onFingerprint);
+  scheduler.start(FPM383_OP_IDENTIFY, false, 200);  // 每个模组每 200ms 识别一次
+}
+
+void loop() {
+  // put your main code here, to run repeatedly:
+  scheduler.poll();
+}
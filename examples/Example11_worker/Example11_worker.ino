@@ -0,0 +1,50 @@
+/*
+  指纹识别模块测试程序（ESP32）
+  后台任务模式：FreeRTOS 任务在核1独占模组串口，loop() 只提交指令并查询结果，不会被串口收发阻塞；
+  后台任务与 loop() 同在核1，等待手指期间每次查询应答后让出处理器（vTaskDelay(1)），loop() 照常运行；
+  LED 状态可随时设置，连续多次设置只发送最后一次
+
+  更多指令集请参见：http://file.yfrobot.com.cn/datasheet/FPM383C%E6%A8%A1%E7%BB%84%E9%80%9A%E4%BF%A1%E5%8D%8F%E8%AE%AE_V1.2.pdf
+
+  Author     : YFROBOT ZL
+  Website    : www.yfrobot.com.cn
+  update Time: 2024-04-11
+*/
+
+#include "yfrobot_fpm383.h"
+#include "fpm383_worker.h"
+
+YFROBOTFPM383 fpm(16, 17);  // 使用 ESP32 的硬件串口2，自定义引脚RX：16    TX：17
+FPM383Worker worker(fpm);
+FPM383Future result;
+bool waiting = false;
+
+void setup() {
+  // put your setup code here, to run once:
+  Serial.begin(9600);
+
+  // 初始化：探测模组波特率并读取指纹库容量等参数
+  while (!fpm.begin()) {
+    Serial.println("等待......");
+    delay(200);  //等待指纹识别模块初始化完成
+  }
+  worker.begin();  // 此后只能通过 worker 访问模组
+  worker.led(3, 1, 1, 0);  // 蓝灯常亮
+}
+
+void loop() {
+  // put your main code here, to run repeatedly:
+  if (!waiting) {
+    waiting = worker.identify(false, &result);
+  } else if (result.ready()) {
+    waiting = false;
+    uint8_t id = result.get();
+    if (id == 0xFE) {
+      Serial.println("未认证指纹");
+    } else if (id != 0xFF) {
+      Serial.print("识别到指纹");
+      Serial.println(id);
+    }
+  }
+  // 其他任务（网络、界面等）在此运行，识别等待手指期间同样执行，不受模组通信影响
+}
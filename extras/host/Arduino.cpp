@@ -0,0 +1,134 @@
+/******************************************************************************
+  Arduino.cpp
+  YFROBOT FPM383 Sensor Library Linux host shim
+  Update Date: 04-11-2024
+  @ YFROBOT
+
+  Distributed as-is; no warranty is given.
+******************************************************************************/
+
+#include "Arduino.h"
+#include <stdio.h>
+#include <atomic>
+
+static std::atomic<uint64_t> hostMicros(0);     // 后台任务线程（FPM383Worker）与主线程共用
+static uint32_t hostStep = 1;
+static uint8_t hostPins[HOST_PIN_COUNT];
+
+HostSerial Serial;
+
+void hostClockReset()
+{
+    hostMicros = 0;
+}
+
+uint64_t hostClockMicros()
+{
+    return hostMicros;
+}
+
+void hostClockAdvance(uint64_t us)
+{
+    hostMicros += us;
+}
+
+void hostClockSetStep(uint32_t us)
+{
+    hostStep = us;
+}
+
+unsigned long millis()
+{
+    return (unsigned long)((hostMicros += hostStep) / 1000);
+}
+
+unsigned long micros()
+{
+    return (unsigned long)(hostMicros += hostStep);
+}
+
+void delay(unsigned long ms)
+{
+    hostMicros += (uint64_t)ms * 1000;
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    hostMicros += us;
+}
+
+void yield()
+{
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if (pin < HOST_PIN_COUNT && mode == INPUT_PULLUP) hostPins[pin] = HIGH;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    if (pin < HOST_PIN_COUNT) hostPins[pin] = value ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin)
+{
+    return pin < HOST_PIN_COUNT ? hostPins[pin] : LOW;
+}
+
+static void (*hostIsr[HOST_PIN_COUNT])();
+static int hostIsrMode[HOST_PIN_COUNT];
+
+void hostPinWrite(uint8_t pin, uint8_t value)
+{
+    if (pin >= HOST_PIN_COUNT) return;
+    uint8_t old = hostPins[pin];
+    digitalWrite(pin, value);
+    uint8_t now = hostPins[pin];
+    if (old == now || hostIsr[pin] == NULL) return;
+    int mode = hostIsrMode[pin];
+    if (mode == CHANGE || (mode == RISING && now == HIGH) || (mode == FALLING && now == LOW)) hostIsr[pin]();
+}
+
+void attachInterrupt(uint8_t interrupt, void (*isr)(), int mode)
+{
+    if (interrupt >= HOST_PIN_COUNT) return;
+    hostIsr[interrupt] = isr;
+    hostIsrMode[interrupt] = mode;
+}
+
+void detachInterrupt(uint8_t interrupt)
+{
+    if (interrupt < HOST_PIN_COUNT) hostIsr[interrupt] = NULL;
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+}
+
+size_t Print::print(const char *s)
+{
+    return write((const uint8_t *)s, strlen(s));
+}
+
+size_t Print::print(long value)
+{
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%ld", value);
+    return print(buf);
+}
+
+size_t Print::print(unsigned long value)
+{
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%lu", value);
+    return print(buf);
+}
+
+size_t HostSerial::write(uint8_t c)
+{
+    return fputc(c, stdout) == EOF ? 0 : 1;
+}
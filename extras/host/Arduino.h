@@ -0,0 +1,112 @@
+/******************************************************************************
+  Arduino.h
+  YFROBOT FPM383 Sensor Library Linux host shim
+  Update Date: 04-11-2024
+  @ YFROBOT
+
+  在 Linux 上编译本库所需的最小 Arduino 接口：虚拟时钟、String、Print/Stream、
+  GPIO 表。仅用于模拟器、基准测试，不会被 Arduino IDE 编译。
+
+  Distributed as-is; no warranty is given.
+******************************************************************************/
+
+#ifndef FPM383_HOST_ARDUINO_H
+#define FPM383_HOST_ARDUINO_H
+
+#define FPM383_HOST 1
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#define INPUT           0
+#define OUTPUT          1
+#define INPUT_PULLUP    2
+#define LOW             0
+#define HIGH            1
+
+#define PROGMEM
+#define PSTR(s)             (s)
+#define pgm_read_byte(p)    (*(const uint8_t *)(p))
+#define memcpy_P            memcpy
+
+// 虚拟时钟（微秒）。每次调用 millis()/micros() 推进 step 微秒，模拟轮询本身的耗时，
+// 使忙等循环在虚拟时间中也能前进；delay() 直接推进对应时间。
+void hostClockReset();
+uint64_t hostClockMicros();
+void hostClockAdvance(uint64_t us);
+void hostClockSetStep(uint32_t us);
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// GPIO 表，模拟器可通过 hostPinWrite() 驱动输入引脚，电平变化时调用 attachInterrupt() 注册的中断函数
+#define HOST_PIN_COUNT  64
+#define CHANGE          1
+#define FALLING         2
+#define RISING          3
+#define NOT_AN_INTERRUPT        -1
+#define digitalPinToInterrupt(p)    ((p) < HOST_PIN_COUNT ? (int)(p) : NOT_AN_INTERRUPT)
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void hostPinWrite(uint8_t pin, uint8_t value);
+void attachInterrupt(uint8_t interrupt, void (*isr)(), int mode);
+void detachInterrupt(uint8_t interrupt);
+
+class String : public std::string
+{
+  public:
+    String() {}
+    String(const char *s) : std::string(s ? s : "") {}
+    String(const std::string &s) : std::string(s) {}
+    explicit String(char c) : std::string(1, c) {}
+    explicit String(int value) : std::string(std::to_string(value)) {}
+    explicit String(unsigned int value) : std::string(std::to_string(value)) {}
+    explicit String(long value) : std::string(std::to_string(value)) {}
+    explicit String(unsigned long value) : std::string(std::to_string(value)) {}
+    unsigned int length() const { return (unsigned int)size(); }
+};
+
+class Print
+{
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    size_t print(const char *s);
+    size_t print(const String &s) { return print(s.c_str()); }
+    size_t print(long value);
+    size_t print(unsigned long value);
+    size_t print(int value) { return print((long)value); }
+    size_t print(unsigned int value) { return print((unsigned long)value); }
+    size_t println() { return print("\n"); }
+    template <typename T> size_t println(const T &value) { return print(value) + println(); }
+};
+
+class Stream : public Print
+{
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+};
+
+// 标准输出串口
+class HostSerial : public Stream
+{
+  public:
+    void begin(unsigned long baud) { (void)baud; }
+    int available() { return 0; }
+    int read() { return -1; }
+    size_t write(uint8_t c);
+    using Print::write;
+};
+
+extern HostSerial Serial;
+
+#endif // FPM383_HOST_ARDUINO_H
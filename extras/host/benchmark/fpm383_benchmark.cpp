@@ -0,0 +1,1091 @@
+/******************************************************************************
+  fpm383_benchmark.cpp
+  YFROBOT FPM383 Sensor Library Linux host benchmark
+  Update Date: 04-11-2024
+  @ YFROBOT
+
+  使用模拟器在虚拟时钟下测量各指令往返延迟与吞吐量，并校验返回结果。
+  任一结果与预期不符时返回非零值，可直接用于 CI。
+
+  Distributed as-is; no warranty is given.
+******************************************************************************/
+
+#include <stdio.h>
+#include "yfrobot_fpm383.h"
+#include "fpm383_simulator.h"
+#include "fpm383_file_storage.h"
+#include "fpm383_scheduler.h"
+#include "fpm383_worker.h"
+#include "fpm383_pgm.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <thread>
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+struct Latency {
+    uint64_t min, max, sum;
+    uint32_t n;
+    Latency() : min(~0ULL), max(0), sum(0), n(0) {}
+    void add(uint64_t us) { if (us < min) min = us; if (us > max) max = us; sum += us; n++; }
+    void print(const char *name) const {
+        printf("  %-32s n=%-5u min=%8.2fms avg=%8.2fms max=%8.2fms\n", name, n,
+               min / 1000.0, n ? sum / 1000.0 / n : 0.0, max / 1000.0);
+    }
+};
+
+static void benchIdentify(uint32_t baud)
+{
+    hostClockReset();
+    FPM383Simulator sim;
+    sim.setModuleBaud(baud);
+    sim.setTemplate(3, 7);
+    YFROBOTFPM383 fpm(&sim);
+    CHECK(fpm.begin(baud));
+    CHECK(fpm.baudRate() == baud);
+
+    Latency hit, miss, none;
+    for (int i = 0; i < 50; i++) {
+        sim.setFinger(7);
+        uint64_t t0 = hostClockMicros();
+        uint8_t id = fpm.identify(false);
+        hit.add(hostClockMicros() - t0);
+        CHECK(id == 3);
+
+        sim.setFinger(9);
+        t0 = hostClockMicros();
+        CHECK(fpm.identify(false) == 0xFE);
+        miss.add(hostClockMicros() - t0);
+
+        sim.setFinger(FPM383_SIM_NO_FINGER);
+        t0 = hostClockMicros();
+        CHECK(fpm.identify(false) == 0xFF);
+        none.add(hostClockMicros() - t0);
+    }
+    printf("identify @ %lu baud\n", (unsigned long)baud);
+    hit.print("enrolled finger");
+    miss.print("unknown finger");
+    none.print("no finger");
+
+    Latency autoHit, autoMiss;
+    for (int i = 0; i < 50; i++) {
+        sim.setFinger(7);
+        uint64_t t0 = hostClockMicros();
+        CHECK(fpm.autoIdentify(false) == 3);
+        autoHit.add(hostClockMicros() - t0);
+        CHECK(fpm.score() > 0);
+
+        sim.setFinger(9);
+        t0 = hostClockMicros();
+        CHECK(fpm.autoIdentify(false) == 0xFE);
+        autoMiss.add(hostClockMicros() - t0);
+    }
+    sim.setFinger(7);
+    CHECK(fpm.autoIdentify(false, FPM383_SECURITY_DEFAULT, 3) == 3);   // 1:1 比对
+    CHECK(fpm.autoIdentify(false, FPM383_SECURITY_DEFAULT, 4) == 0xFE);
+    sim.setFinger(FPM383_SIM_NO_FINGER);
+    CHECK(fpm.autoIdentify(false) == 0xFF);
+    autoHit.print("autoIdentify enrolled finger");
+    autoMiss.print("autoIdentify unknown finger");
+
+    // 去掉模组处理时间（采图30 + 生成特征50 + 搜索10 ms，自动验证同为90 ms），只剩串口传输及主机处理：
+    // 自动验证省下的只是两次往返，处理时间占大头，识别时间无法减半
+    static const uint8_t steps[] = { 0x01, 0x02, 0x04, 0x32 };
+    for (uint8_t i = 0; i < sizeof(steps); i++) sim.setProcessTime(steps[i], 0);
+    sim.setFinger(7);
+    uint64_t t0 = hostClockMicros();
+    CHECK(fpm.identify(false) == 3);
+    uint64_t wire = hostClockMicros() - t0;
+    t0 = hostClockMicros();
+    CHECK(fpm.autoIdentify(false) == 3);
+    uint64_t autoWire = hostClockMicros() - t0;
+    CHECK(autoWire < wire && hit.max - wire == autoHit.max - autoWire);    // 两条路径的模组处理时间相同
+    printf("  %-32s %8.2fms identify, %.2fms autoIdentify, module processing %.2fms\n", "transfer + host only",
+           wire / 1000.0, autoWire / 1000.0, (hit.max - wire) / 1000.0);
+}
+
+static void benchBaud()
+{
+    hostClockReset();
+    FPM383Simulator sim;
+    sim.setModuleBaud(38400);       // 模组停留在非默认波特率
+    YFROBOTFPM383 fpm(&sim);
+
+    printf("baud rate\n");
+    uint64_t t0 = hostClockMicros();
+    CHECK(fpm.begin());
+    CHECK(fpm.baudRate() == 38400);
+    printf("  %-32s %8.2fms -> %lu\n", "begin() auto-detect", (hostClockMicros() - t0) / 1000.0,
+           (unsigned long)fpm.baudRate());
+
+    t0 = hostClockMicros();
+    CHECK(fpm.setBaudRate(115200));
+    CHECK(sim.moduleBaud() == 115200 && fpm.baudRate() == 115200);
+    printf("  %-32s %8.2fms\n", "setBaudRate(115200)", (hostClockMicros() - t0) / 1000.0);
+    CHECK(!fpm.setBaudRate(100000));
+    CHECK(fpm.inquiry() == 0);
+}
+
+static uint8_t backup[2048];
+
+static bool countChunk(void *context, const uint8_t *data, uint16_t length)
+{
+    (void)data;
+    *(uint32_t *)context += length;
+    return true;
+}
+
+// 从 backup 读出模板，读到 context 指定的字节数后不再提供数据（文件截断等）
+static uint32_t sourceRead = 0;
+
+static uint16_t truncatedSource(void *context, uint8_t *data, uint16_t length)
+{
+    uint32_t limit = *(uint32_t *)context;
+    uint16_t n = sourceRead + length > limit ? limit - sourceRead : length;
+    memcpy(data, backup + sourceRead, n);
+    sourceRead += n;
+    return n;
+}
+
+static void benchTemplates(uint32_t baud)
+{
+    hostClockReset();
+    FPM383Simulator sim;
+    sim.setModuleBaud(baud);
+    sim.setTemplate(2, 11);
+    YFROBOTFPM383 fpm(&sim);
+    CHECK(fpm.begin(baud));
+
+    printf("template transfer @ %lu baud\n", (unsigned long)baud);
+    uint32_t length = 0;
+    uint64_t t0 = hostClockMicros();
+    CHECK(fpm.uploadTemplate(2, backup, sizeof(backup), &length) == 0x00);
+    uint64_t up = hostClockMicros() - t0;
+    CHECK(length == FPM383_SIM_TEMPLATE_SIZE);
+    printf("  %-32s %8.2fms %lu bytes (%.0f B/s)\n", "uploadTemplate -> buffer", up / 1000.0,
+           (unsigned long)length, length * 1e6 / up);
+
+    uint32_t streamed = 0;
+    FPM383DataSink sink = { NULL, 0, countChunk, &streamed, 0, NULL };
+    CHECK(fpm.uploadTemplate(2, sink) == 0x00);
+    CHECK(streamed == FPM383_SIM_TEMPLATE_SIZE);
+
+    uint8_t small[100];
+    CHECK(fpm.uploadTemplate(2, small, sizeof(small), &length) == 0xFF);    // 缓冲区不足
+    CHECK(fpm.inquiry() == 1);                                              // 剩余数据包已丢弃，通信正常
+
+    t0 = hostClockMicros();
+    CHECK(fpm.downloadTemplate(9, backup, FPM383_SIM_TEMPLATE_SIZE) == 0x00);
+    uint64_t down = hostClockMicros() - t0;
+    CHECK(sim.templateAt(9) == 11);
+    printf("  %-32s %8.2fms\n", "downloadTemplate <- buffer", down / 1000.0);
+
+    // 回调在数据包中途提供的数据不足：补足已声明的长度，之后的指令不会被模组当作模板数据
+    uint32_t limit = 200;
+    sourceRead = 0;
+    FPM383DataSource source = { NULL, FPM383_SIM_TEMPLATE_SIZE, truncatedSource, &limit };
+    CHECK(fpm.downloadTemplate(10, source) == 0xFF && fpm.lastError() == FPM383_ERROR_ABORTED);
+    CHECK(sourceRead == limit && sim.templateAt(10) < 0);
+    CHECK(fpm.deleteID(9) == 0x00 && sim.templateAt(9) < 0);
+    CHECK(fpm.inquiry() == 1);
+}
+
+static void benchSysPara()
+{
+    hostClockReset();
+    FPM383Simulator sim(60);
+    sim.setPacketSize(32);          // 模组已设置为32字节数据包
+    sim.setTemplate(55, 11);
+    YFROBOTFPM383 fpm(&sim);
+    CHECK(fpm.capacity() == FPM383_CAPACITY_DEFAULT && fpm.packetSize() == FPM383_PACKET_SIZE_DEFAULT);
+    CHECK(fpm.begin(57600));
+    CHECK(fpm.capacity() == 60 && fpm.packetSize() == 32 && fpm.securityLevel() == FPM383_SECURITY_DEFAULT);
+
+    printf("system parameters (capacity %u)\n", (unsigned)fpm.capacity());
+    CHECK(fpm.loadIndex() && fpm.isEnrolled(55) && fpm.nextFreeId(55) == 56);
+    uint16_t id = 0;
+    CHECK(fpm.loadChar(1, 55) == 0x00);
+    CHECK(fpm.searchMB(50, FPM383_SEARCH_ALL, &id) == 0x00 && id == 55);    // 搜索范围按容量截断
+
+    uint32_t frames = sim.framesReceived();         // 超出容量的ID不发送指令
+    CHECK(fpm.deleteID(60) == 0xFF && fpm.lastError() == FPM383_ERROR_RANGE);
+    CHECK(fpm.deleteRange(50, 11) == 0xFF);
+    CHECK(fpm.loadChar(1, 60) == 0xFF);
+    CHECK(fpm.enroll(60, 4) == 0xFF && fpm.lastError() == FPM383_ERROR_RANGE);
+    CHECK(fpm.identify(false, 60) == 0xFF);
+    FPM383Response r;
+    CHECK(fpm.searchMB(60, 1, r) == 0xFF && r.error == FPM383_ERROR_RANGE);
+    CHECK(sim.framesReceived() == frames);
+    CHECK(!fpm.setPacketSize(100));
+
+    uint64_t first = 0, us = 0;
+    static const uint16_t sizes[] = { 32, 64, 128, 256 };
+    for (uint8_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        CHECK(fpm.setPacketSize(sizes[i]));
+        CHECK(sim.packetSize() == sizes[i] && fpm.packetSize() == sizes[i]);
+        uint32_t length = 0;
+        frames = sim.framesReceived();
+        uint64_t t0 = hostClockMicros();
+        CHECK(fpm.uploadTemplate(55, backup, sizeof(backup), &length) == 0x00 && length == FPM383_SIM_TEMPLATE_SIZE);
+        CHECK(fpm.downloadTemplate(56 + i, backup, length) == 0x00);
+        us = hostClockMicros() - t0;
+        CHECK(sim.templateAt(56 + i) == 11);    // 数据包不超过模组数据包大小，下载数据完整
+        if (i == 0) first = us;
+        char name[40];
+        snprintf(name, sizeof(name), "template up+down, %u B packets", (unsigned)sizes[i]);
+        printf("  %-32s %8.2fms %3u frames sent\n", name, us / 1000.0, (unsigned)(sim.framesReceived() - frames));
+    }
+    CHECK(us * 10 < first * 9);     // 256 字节数据包比32字节至少快10%
+
+    // 未调用 begin()：容量未知，不在本地检查ID范围，超出默认容量50的ID照常发送给模组
+    FPM383Simulator large(60);
+    large.setTemplate(55, 11);
+    large.setFinger(12);
+    YFROBOTFPM383 raw(&large);
+    CHECK(raw.loadChar(1, 55) == 0x00);
+    CHECK(raw.enroll(58, 2) == 0x00 && large.templateAt(58) == 12);
+    CHECK(raw.identify(false, 50, 10) == 58);
+    CHECK(raw.beginIdentify(false, 52));
+    while (raw.poll() == FPM383_BUSY) {}
+    CHECK(raw.result() == 58);
+    CHECK(raw.deleteID(55) == 0x00 && large.templateAt(55) < 0);
+    CHECK(raw.deleteID(60) != 0x00 && raw.lastError() != FPM383_ERROR_RANGE);  // 由模组拒绝
+}
+
+static uint8_t image[FPM383_IMAGE_SIZE];
+
+struct ImageReader
+{
+    FPM383RingBuffer *ring;
+    FPM383PGMWriter *writer;
+    std::atomic<bool> done;
+};
+
+// 环形缓冲区的读取方：与上传同时运行，边读出边写入文件
+static void readImage(ImageReader *reader)
+{
+    while (!reader->done) {
+        if (reader->writer->drain(*reader->ring) == 0) std::this_thread::yield();
+    }
+    reader->writer->drain(*reader->ring);
+}
+
+static void benchImage(uint32_t baud)
+{
+    hostClockReset();
+    FPM383Simulator sim;
+    sim.setModuleBaud(baud);
+    YFROBOTFPM383 fpm(&sim);
+    CHECK(fpm.begin(baud));
+
+    printf("image upload @ %lu baud\n", (unsigned long)baud);
+    CHECK(fpm.upImage(image, sizeof(image), NULL) == 0x15);     // 尚未采集图像
+    sim.setFinger(5);
+    CHECK(fpm.getImage() == 0x00);
+    uint32_t length = 0;
+    uint64_t t0 = hostClockMicros();
+    CHECK(fpm.upImage(image, sizeof(image), &length) == 0x00);
+    uint64_t up = hostClockMicros() - t0;
+    CHECK(length == FPM383_IMAGE_SIZE);
+    CHECK(memcmp(image, &FPM383Simulator::imageData(5)[0], FPM383_IMAGE_SIZE) == 0);
+    CHECK(fpm.transferRate() > baud / 11 * 85 / 100);         // 8N2 每字节11位，数据包头尾开销约8%
+    printf("  %-32s %8.2fms %lu bytes (%lu B/s)\n", "upImage -> buffer", up / 1000.0,
+           (unsigned long)length, (unsigned long)fpm.transferRate());
+
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/fpm383_image_%lu.pgm", (unsigned long)baud);
+    uint8_t ringBuffer[512];
+    FPM383RingBuffer ring(ringBuffer, sizeof(ringBuffer));
+    FPM383PGMWriter writer;
+    CHECK(writer.open(path));
+    ImageReader reader = { &ring, &writer, { false } };
+    std::thread consumer(readImage, &reader);
+    t0 = hostClockMicros();
+    CHECK(fpm.upImage(ring) == 0x00);
+    up = hostClockMicros() - t0;
+    reader.done = true;
+    consumer.join();
+    CHECK(writer.written() == FPM383_IMAGE_SIZE && writer.close());
+    printf("  %-32s %8.2fms via %u-byte ring -> %s\n", "upImage -> ring -> PGM", up / 1000.0,
+           (unsigned)sizeof(ringBuffer), path);
+
+    FILE *f = fopen(path, "rb");
+    CHECK(f != NULL);
+    if (f != NULL) {
+        char header[32];
+        size_t n = fread(header, 1, 15, f);
+        header[n] = 0;
+        CHECK(strcmp(header, "P5\n160 160\n255\n") == 0);
+        CHECK(fread(image, 1, sizeof(image), f) == FPM383_IMAGE_SIZE && fgetc(f) == EOF);
+        fclose(f);
+        CHECK(memcmp(image, &FPM383Simulator::imageData(5)[0], FPM383_IMAGE_SIZE) == 0);
+    }
+    unlink(path);
+    CHECK(fpm.inquiry() == 0);
+}
+
+static void benchIndex()
+{
+    hostClockReset();
+    FPM383Simulator sim;
+    for (uint16_t id = 0; id < 10; id++) sim.setTemplate(id, 100 + id);
+    sim.setTemplate(12, 200);
+    sim.setTemplate(49, 201);
+    YFROBOTFPM383 fpm(&sim);
+
+    printf("index table\n");
+    uint64_t t0 = hostClockMicros();
+    CHECK(fpm.loadIndex());
+    printf("  %-32s %8.2fms\n", "loadIndex", (hostClockMicros() - t0) / 1000.0);
+    CHECK(fpm.enrolledCount() == 12);
+    CHECK(fpm.isEnrolled(12) && !fpm.isEnrolled(11));
+    CHECK(fpm.nextFreeId() == 10);
+    CHECK(fpm.nextEnrolled(10) == 12);
+    CHECK(fpm.nextEnrolled(13) == 49);
+    CHECK(fpm.nextEnrolled(50) == FPM383_NO_ID);
+
+    sim.setFinger(300);
+    CHECK(fpm.enroll(fpm.nextFreeId(), 4) == 0x00);     // 无需试探即可注册到空闲ID
+    CHECK(fpm.isEnrolled(10) && fpm.nextFreeId() == 11);
+    CHECK(fpm.deleteID(12) == 0x00);
+    CHECK(!fpm.isEnrolled(12));
+    CHECK(fpm.empty() == 0x00);
+    CHECK(fpm.enrolledCount() == 0 && fpm.nextFreeId() == 0);
+
+    // 容量超出位图：位图内已满时不能报告指纹库已满
+    FPM383Simulator big(FPM383_MAX_IDS + 36);
+    for (uint16_t id = 0; id < FPM383_MAX_IDS; id++) big.setTemplate(id, 400 + id);
+    big.setTemplate(FPM383_MAX_IDS + 2, 500);
+    YFROBOTFPM383 wide(&big);
+    CHECK(wide.begin());
+    CHECK(wide.loadIndex() && !wide.indexValid() && wide.lastError() == FPM383_ERROR_RANGE);
+    CHECK(wide.enrolledCount() == FPM383_MAX_IDS && wide.nextFreeId() == FPM383_ID_UNTRACKED);
+}
+
+// 用户ID u 对应手指编号 STORE_FINGER + u
+static const int STORE_FINGER = 1000;
+static const uint16_t STORE_USERS = 200;
+static const uint16_t STORE_SLOTS = 20;
+
+static bool removeUser(void *context, uint16_t user)
+{
+    ((FPM383FileStorage *)context)->remove(user);
+    return true;
+}
+
+// 80% 的识别来自 20 个常用用户（每隔10个ID一个），其余均匀分布
+static uint16_t nextVisitor(uint32_t &seed)
+{
+    seed = seed * 1103515245 + 12345;
+    uint32_t r = (seed >> 8) % 1000;
+    return r < 800 ? (r % 20) * 10 : r % STORE_USERS;
+}
+
+static void benchStorePolicy(const char *dir, uint8_t policy, const char *name)
+{
+    hostClockReset();
+    FPM383Simulator sim;
+    sim.setTemplate(30, 5);                                 // 常驻区外的模板不受影响
+    sim.setTemplate(3, 6);                                  // 常驻区内的旧模板在 begin() 时删除
+    YFROBOTFPM383 fpm(&sim);
+    CHECK(fpm.begin(57600));
+    FPM383FileStorage storage(dir);
+    FPM383TemplateStore store(fpm, storage, 0, STORE_SLOTS, policy);
+    CHECK(store.begin());
+    CHECK(store.userCount() == STORE_USERS);
+    CHECK(sim.templateAt(3) < 0 && sim.templateAt(30) == 5);
+
+    Latency hit, cold, call;
+    uint32_t seed = 1;
+    for (int i = 0; i < 300; i++) {
+        if (i == 100) store.resetStats();
+        uint16_t user = nextVisitor(seed);
+        sim.setFinger(STORE_FINGER + user);
+        uint32_t coldHits = store.stats().coldHits;
+        uint64_t t0 = hostClockMicros();
+        uint16_t found;
+        do {                                                // 达到比对上限时手指仍在，继续识别
+            uint64_t t1 = hostClockMicros();
+            found = store.identify();
+            if (i >= 100) call.add(hostClockMicros() - t1);
+        } while (found == FPM383_STORE_PARTIAL);
+        uint64_t t = hostClockMicros() - t0;
+        CHECK(found == user);
+        if (i < 100) continue;                              // 前100次为预热，不计入统计
+        (store.stats().coldHits != coldHits ? cold : hit).add(t);
+    }
+    const FPM383StoreStats &st = store.stats();
+    printf("  %s: hit rate %.1f%% (%lu/%lu), page-ins %lu, evictions %lu, downloads %lu\n", name,
+           store.hitRate() * 100, (unsigned long)st.hits, (unsigned long)st.lookups,
+           (unsigned long)st.pageIns, (unsigned long)st.evictions, (unsigned long)st.downloads);
+    hit.print("resident 1:N");
+    cold.print("host paging");
+    call.print("single identify() call");
+    CHECK(call.max < (FPM383_STORE_COLD_MAX + 2) * 350000ULL);     // 单次调用时间受比对上限约束
+    CHECK(store.hitRate() > 0.5f);
+}
+
+static void benchTemplateStore()
+{
+    char dir[] = "/tmp/fpm383_storeXXXXXX";
+    CHECK(mkdtemp(dir) != NULL);
+    FPM383FileStorage storage(dir);
+    for (uint16_t user = 0; user < STORE_USERS; user++) {
+        std::vector<uint8_t> data = FPM383Simulator::templateData(STORE_FINGER + user);
+        CHECK(storage.save(user, &data[0], data.size()));
+    }
+
+    printf("template store (%u users, %u resident)\n", STORE_USERS, STORE_SLOTS);
+    benchStorePolicy(dir, FPM383_STORE_LRU, "LRU");
+    benchStorePolicy(dir, FPM383_STORE_LFU, "LFU");
+
+    hostClockReset();
+    FPM383Simulator sim;
+    YFROBOTFPM383 fpm(&sim);
+    CHECK(fpm.begin(57600));
+    FPM383TemplateStore store(fpm, storage, 10, 4);
+    CHECK(store.begin());
+    sim.setFinger(77);
+    Latency partial, full;
+    uint16_t calls = 0, found;
+    uint64_t t0 = hostClockMicros();
+    do {                                                    // 未知手指：每次最多比对 FPM383_STORE_COLD_MAX 个
+        uint64_t t1 = hostClockMicros();
+        found = store.identify();
+        partial.add(hostClockMicros() - t1);
+        calls++;
+    } while (found == FPM383_STORE_PARTIAL);
+    uint64_t pass = hostClockMicros() - t0;
+    CHECK(found == FPM383_STORE_UNKNOWN && calls == (STORE_USERS + FPM383_STORE_COLD_MAX - 1) / FPM383_STORE_COLD_MAX);
+    CHECK(store.stats().misses == 1 && store.stats().downloads == STORE_USERS);
+    store.setColdLimit(0);                                  // 不限制：一次比对全部非常驻模板
+    t0 = hostClockMicros();
+    CHECK(store.identify() == FPM383_STORE_UNKNOWN);
+    full.add(hostClockMicros() - t0);
+    store.setColdLimit(FPM383_STORE_COLD_MAX);
+    printf("  unknown finger: %u calls, %.0fms per call (limit %u), %.0fms per pass, %.0fms unlimited (%.1fms per user)\n",
+           calls, partial.max / 1000.0, FPM383_STORE_COLD_MAX, pass / 1000.0, full.max / 1000.0,
+           full.max / 1000.0 / STORE_USERS);
+
+    sim.setFinger(FPM383_SIM_NO_FINGER);
+    CHECK(store.identify(false) == FPM383_STORE_NO_FINGER);
+    sim.setFinger(77);
+    CHECK(store.enroll(500, 4) == 0x00);                    // 注册到常驻区并保存到主机存储
+    CHECK(store.resident(500) && store.contains(500));
+    CHECK(sim.templateAt(10) == 77);
+    CHECK(store.identify(false) == 500);
+    CHECK(store.pageIn(42) && sim.templateAt(11) == STORE_FINGER + 42);
+    CHECK(store.remove(500) && !store.contains(500) && sim.templateAt(10) < 0);
+    CHECK(!storage.load(500, backup, sizeof(backup), NULL));
+
+    // 返回 PARTIAL 后换了手指：移开手指或间隔过长都从头比对，排在前面的用户不能漏掉
+    sim.setFinger(77);
+    CHECK(store.identify() == FPM383_STORE_PARTIAL);
+    sim.setFinger(FPM383_SIM_NO_FINGER);
+    CHECK(store.identify() == FPM383_STORE_NO_FINGER);
+    sim.setFinger(STORE_FINGER + 1);
+    CHECK(store.identify() == 1);
+    sim.setFinger(77);
+    CHECK(store.identify() == FPM383_STORE_PARTIAL);
+    hostClockAdvance((FPM383_STORE_RESUME_GAP + 1) * 1000ULL);
+    sim.setFinger(STORE_FINGER + 2);
+    CHECK(store.identify() == 2);
+
+    storage.list(removeUser, &storage);
+    rmdir(dir);
+}
+
+static uint32_t asyncDone = 0;
+
+static void onDone(YFROBOTFPM383 *fpm, uint8_t op, uint8_t result)
+{
+    (void)fpm;
+    if (op == FPM383_OP_IDENTIFY && result == 3) asyncDone++;
+}
+
+static void benchAsync()
+{
+    hostClockReset();
+    FPM383Simulator sim;
+    sim.setTemplate(3, 7);
+    sim.setFinger(7);
+    YFROBOTFPM383 fpm(&sim);
+    fpm.onComplete(onDone);
+
+    asyncDone = 0;
+    uint64_t loops = 0;
+    const uint64_t window = 10000000ULL;   // 10 s 虚拟时间
+    while (hostClockMicros() < window) {
+        fpm.poll();
+        if (!fpm.busy()) fpm.beginIdentify(false);
+        loops++;
+    }
+    printf("async identify\n");
+    printf("  %-32s %u in 10 s (%.1f/s), %llu loop() iterations\n", "completed", asyncDone,
+           asyncDone / 10.0, (unsigned long long)loops);
+    CHECK(asyncDone > 0);
+}
+
+static uint32_t schedDone[FPM383_SCHED_MAX];
+static FPM383Scheduler *schedCurrent = NULL;
+
+static void onSchedDone(YFROBOTFPM383 *fpm, uint8_t op, uint8_t result)
+{
+    int i = schedCurrent->indexOf(fpm);
+    if (i >= 0 && op == FPM383_OP_IDENTIFY && result == 3) schedDone[i]++;
+}
+
+// 多个模组轮询调度，返回 10 s 内完成的识别总数
+static uint32_t benchScheduler(uint8_t n)
+{
+    hostClockReset();
+    FPM383Simulator sims[4];
+    YFROBOTFPM383 *fpms[4];
+    FPM383Scheduler sched;
+    schedCurrent = &sched;
+    for (uint8_t i = 0; i < n; i++) {
+        sims[i].setTemplate(3, 7);
+        sims[i].setFinger(7);
+        fpms[i] = new YFROBOTFPM383(&sims[i]);
+        CHECK(sched.add(*fpms[i]));
+        schedDone[i] = 0;
+    }
+    sched.onComplete(onSchedDone);
+    CHECK(sched.start(FPM383_OP_IDENTIFY, false, 0));
+
+    const uint64_t window = 10000000ULL;
+    while (hostClockMicros() < window) sched.poll();
+    sched.stop();
+    while (sched.poll()) {}
+
+    uint32_t total = 0, least = ~0U;
+    for (uint8_t i = 0; i < n; i++) {
+        total += schedDone[i];
+        if (schedDone[i] < least) least = schedDone[i];
+        delete fpms[i];
+    }
+    char name[32];
+    snprintf(name, sizeof(name), "%u sensor%s", n, n > 1 ? "s" : "");
+    printf("  %-32s %u in 10 s (%.1f/s), slowest sensor %u\n", name, total, total / 10.0, least);
+    CHECK(least > 0);
+    return total;
+}
+
+static std::atomic<uint32_t> workerCallbacks(0);
+
+static void onWorkerDone(void *context, uint8_t op, uint8_t result)
+{
+    (void)context;
+    if (op == FPM383_OP_IDENTIFY && result == 3) workerCallbacks++;
+}
+
+// 后台任务：主线程只提交指令和 LED 状态，不访问串口
+static void benchWorker()
+{
+    hostClockReset();
+    FPM383Simulator sim;
+    sim.setTemplate(3, 7);
+    sim.setFinger(7);
+    YFROBOTFPM383 fpm(&sim);
+    FPM383Worker worker(fpm);
+    CHECK(!worker.identify(false));         // 未启动
+    CHECK(worker.begin());
+
+    const int N = 10;
+    FPM383Future futures[N];
+    workerCallbacks = 0;
+    uint64_t t0 = hostClockMicros();
+    for (int i = 0; i < N; i++) CHECK(worker.identify(false, &futures[i], onWorkerDone));
+    uint32_t submitted = 0;
+    for (uint8_t i = 0; i < 100; i++, submitted++) worker.led(2, i & 7, i & 7, 1);
+    for (int i = 0; i < N; i++) CHECK(futures[i].get() == 3 && futures[i].score() > 0);
+    uint64_t elapsed = hostClockMicros() - t0;
+    CHECK(workerCallbacks == (uint32_t)N);
+
+    worker.led(3, 2, 2, 0);
+    FPM383Future del, miss, add;
+    CHECK(worker.deleteID(3, &del));
+    CHECK(del.get() == 0x00);
+    CHECK(sim.led() == (3 | 2 << 8 | 2 << 16));     // 执行下一条指令前发送了最后一次设置的状态
+    CHECK(worker.identify(false, &miss));
+    CHECK(miss.get() == 0xFE && miss.score() == 0);     // 不沿用上次识别成功的得分
+    CHECK(worker.enroll(5, 2, &add));
+    CHECK(add.get() == 0x00 && sim.templateAt(5) == 7);
+    uint32_t requests = worker.ledRequests(), sent = worker.ledSent();
+    CHECK(requests == submitted + 1 && sent < requests && sent > 0);
+
+    FPM383Future queued[4];
+    for (int i = 0; i < 4; i++) worker.identify(false, &queued[i]);
+    worker.end();
+    for (int i = 0; i < 4; i++) {
+        CHECK(queued[i].ready());
+        CHECK(queued[i].get() == 0xFE || queued[i].get() == FPM383_RESULT_CANCELLED);
+    }
+    CHECK(!worker.running() && worker.pending() == 0);
+    CHECK(!worker.identify(false));         // 已停止
+
+    // end() 与其他线程的 submit() 同时进行：被接受的指令必须完成（执行或取消），之后的提交被拒绝
+    uint32_t accepted = 0, completed = 0;
+    for (int round = 0; round < 20; round++) {
+        CHECK(worker.begin());
+        FPM383Future racing[64];
+        std::atomic<bool> go(false);
+        int n = 0;
+        std::thread producer([&]() {
+            while (!go) std::this_thread::yield();
+            for (n = 0; n < 64; n++) {
+                if (!worker.identify(false, &racing[n])) break;
+            }
+        });
+        go = true;
+        std::this_thread::sleep_for(std::chrono::microseconds(round * 20));
+        worker.end();
+        producer.join();
+        accepted += n;
+        for (int i = 0; i < n; i++) completed += racing[i].ready();
+        CHECK(!worker.identify(false));
+    }
+    CHECK(accepted > 0 && completed == accepted);
+
+    printf("background worker\n");
+    printf("  %-32s %8.2fms each\n", "queued identify", elapsed / 1000.0 / N);
+    printf("  %-32s %u requested, %u sent\n", "LED coalescing", requests, sent);
+}
+
+// LED 指令不等待应答，应答在之后的收发中计数丢弃
+static void benchPipeline()
+{
+    hostClockReset();
+    FPM383Simulator sim;
+    sim.setTemplate(3, 7);
+    sim.setFinger(7);
+    sim.setProcessTime(0x3C, 8000);         // LED 指令处理较慢
+    YFROBOTFPM383 fpm(&sim);
+
+    Latency led, identify;
+    for (int i = 0; i < 20; i++) {
+        uint64_t t0 = hostClockMicros();
+        fpm.controlLEDC(3, 1, 1, 0);
+        led.add(hostClockMicros() - t0);
+        CHECK(fpm.pendingAcks() >= 1);
+        t0 = hostClockMicros();
+        CHECK(fpm.identify(false) == 3);    // 紧接着发送，LED 应答不会被当作获取图像的应答
+        identify.add(hostClockMicros() - t0);
+    }
+    CHECK(fpm.pendingAcks() == 1);          // 识别成功后的绿灯指令
+    for (int i = 0; i < 1000 && fpm.pendingAcks() > 0; i++) {
+        hostClockAdvance(100);
+        fpm.poll();                         // 空闲时 poll() 处理到达的应答
+    }
+    CHECK(fpm.pendingAcks() == 0 && fpm.acksLost() == 0);
+    CHECK(sim.commandCount(0x3C) == 40);
+    fpm.sleep();
+    CHECK(fpm.inquiry() == 1 && fpm.pendingAcks() == 0);
+
+    // LED 应答损坏（丢失）：之后指令只有确认码的应答不能被当作该 LED 应答
+    Latency lost;
+    sim.setTemplate(8, 9);
+    sim.corruptReplies(1);
+    fpm.controlLEDC(3, 1, 1, 0);
+    uint64_t t0 = hostClockMicros();
+    CHECK(fpm.deleteID(8) == 0x00);
+    lost.add(hostClockMicros() - t0);
+    CHECK(sim.templateAt(8) < 0 && fpm.acksLost() == 1 && fpm.pendingAcks() == 0);
+
+    // 异步操作不阻塞等待流水线指令应答：应答由 poll() 处理（丢失时等待超时）后再发送指令
+    Latency begin;
+    sim.corruptReplies(1);
+    fpm.controlLEDC(3, 1, 1, 0);
+    t0 = hostClockMicros();
+    CHECK(fpm.beginIdentify(false));
+    begin.add(hostClockMicros() - t0);
+    uint8_t state;
+    while ((state = fpm.poll()) == FPM383_BUSY) hostClockAdvance(100);
+    CHECK(state == FPM383_DONE && fpm.result() == 3 && fpm.acksLost() == 2);
+    t0 = hostClockMicros();
+    CHECK(fpm.beginEnroll(10, 2));          // 蓝灯应答未到达，不发送自动注册指令
+    begin.add(hostClockMicros() - t0);
+    CHECK(fpm.poll() == FPM383_BUSY && fpm.abort());
+    while ((state = fpm.poll()) == FPM383_BUSY) hostClockAdvance(100);
+    CHECK(fpm.result() == FPM383_RESULT_CANCELLED && sim.commandCount(0x31) == 0);
+    for (int i = 0; i < 1000 && fpm.pendingAcks() > 0; i++) {
+        hostClockAdvance(100);
+        fpm.poll();
+    }
+    CHECK(fpm.pendingAcks() == 0 && fpm.acksLost() == 2);
+    CHECK(begin.max < 5000);
+    printf("pipelined LED\n");
+    led.print("controlLEDC (no wait)");
+    identify.print("identify after LED");
+    lost.print("deleteID after lost LED ack");
+    begin.print("begin* after LED (no wait)");
+}
+
+static void benchResync()
+{
+    hostClockReset();
+    FPM383Simulator sim;
+    sim.setTemplate(1, 5);
+    sim.setFinger(5);
+    sim.setBurst(6, 3000);          // 应答包分两段到达，中间停顿 3 ms
+    YFROBOTFPM383 fpm(&sim);
+
+    static const uint8_t noise[] = { 0x55, 0xEF, 0x00, 0xEF, 0x01, 0xFF };
+    Latency split;
+    for (int i = 0; i < 20; i++) {
+        sim.injectNoise(noise, sizeof(noise));
+        uint64_t t0 = hostClockMicros();
+        CHECK(fpm.identify(false) == 1);
+        split.add(hostClockMicros() - t0);
+    }
+    printf("split frames + noise\n");
+    split.print("enrolled finger");
+}
+
+static uint8_t progressStages[32];
+static uint8_t progressCount = 0;
+static bool cancelOnBadCapture = false;
+
+static bool onProgress(YFROBOTFPM383 *fpm, uint8_t stage, uint8_t index, uint8_t code)
+{
+    (void)fpm;
+    (void)index;
+    if (progressCount < sizeof(progressStages)) progressStages[progressCount++] = stage;
+    return !(cancelOnBadCapture && code != 0x00);
+}
+
+static void benchEnrollProgress()
+{
+    hostClockReset();
+    FPM383Simulator sim;
+    sim.setFinger(40);
+    YFROBOTFPM383 fpm(&sim);
+    fpm.onEnrollProgress(onProgress);
+
+    printf("enroll progress\n");
+    uint64_t t0 = hostClockMicros();
+    CHECK(fpm.enroll(3, 4) == 0x00);
+    printf("  %-32s %8.2fms, %u status packets\n", "enroll (4 captures)", (hostClockMicros() - t0) / 1000.0, progressCount);
+    // 4 次采集各有获取图像、生成特征，前 3 次有手指离开，之后合并、检验、存储
+    static const uint8_t expected[] = { 1, 2, 3, 1, 2, 3, 1, 2, 3, 1, 2, 4, 5, 6 };
+    CHECK(progressCount == sizeof(expected) && memcmp(progressStages, expected, sizeof(expected)) == 0);
+    CHECK(sim.templateAt(3) == 40);
+
+    sim.setBadCapture(2);                                   // 第2次采集特征点太少
+    progressCount = 0;
+    t0 = hostClockMicros();
+    CHECK(fpm.enroll(4, 4) == 0x00);                        // 不取消：模组重新采集
+    uint64_t retry = hostClockMicros() - t0;
+    CHECK(progressCount == sizeof(expected) + 2 && sim.templateAt(4) == 40);
+
+    cancelOnBadCapture = true;
+    t0 = hostClockMicros();
+    CHECK(fpm.enroll(5, 4) == FPM383_RESULT_CANCELLED);    // 采集失败立即取消
+    uint64_t cancelled = hostClockMicros() - t0;
+    CHECK(sim.templateAt(5) < 0 && !fpm.isEnrolled(5));
+    CHECK(sim.commandCount(0x30) == 1);
+    printf("  %-32s %8.2fms\n", "bad capture, module retries", retry / 1000.0);
+    printf("  %-32s %8.2fms\n", "bad capture, cancelled", cancelled / 1000.0);
+    CHECK(fpm.inquiry() == 2);                              // 取消后剩余的状态包已丢弃，通信正常
+
+    uint8_t *reply = fpm.autoEnroll(6, 4);                  // 同步接口同样可以取消
+    CHECK(reply[0] == 0xFF && sim.templateAt(6) < 0);
+    CHECK(fpm.inquiry() == 2);
+    cancelOnBadCapture = false;
+    reply = fpm.autoEnroll(6, 4);
+    CHECK(reply[0] == 0x00 && reply[1] == FPM383_ENROLL_STORE && reply[2] == 0xF2 && sim.templateAt(6) == 40);
+
+    fpm.onEnrollProgress(NULL);                             // 关闭状态返回
+    sim.setBadCapture(0);
+    progressCount = 0;
+    CHECK(fpm.enroll(7, 4) == 0x00 && progressCount == 0);
+
+    sim.setFinger(FPM383_SIM_NO_FINGER);                    // 自动验证等待手指时取消
+    CHECK(fpm.beginAutoIdentify(false));
+    delay(100);
+    CHECK(fpm.abort());
+    t0 = hostClockMicros();
+    while (fpm.poll() == FPM383_BUSY)
+        ;
+    CHECK(fpm.result() == FPM383_RESULT_CANCELLED);
+    printf("  %-32s %8.2fms\n", "abort autoIdentify", (hostClockMicros() - t0) / 1000.0);
+    CHECK(fpm.inquiry() == 4);
+}
+
+// 手指在 touchTime(k) 按下，识别成功 300 ms 后抬起
+static const int TOUCHES = 20;
+static const uint8_t TOUCH_PIN = 2;
+
+static uint64_t touchTime(int k)
+{
+    return (1500 + k * 2900 + (k * 373) % 1000) * 1000ULL;
+}
+
+static uint8_t touchOp = FPM383_OP_NONE;
+static uint8_t touchResult = 0xFF;
+
+static void onTouchDone(YFROBOTFPM383 *fpm, uint8_t op, uint8_t result)
+{
+    (void)fpm;
+    touchOp = op;
+    touchResult = result;
+}
+
+static void benchTouch(bool wake)
+{
+    hostClockReset();
+    FPM383Simulator sim;
+    sim.setTemplate(1, 5);
+    YFROBOTFPM383 fpm(&sim);
+    if (wake) {
+        sim.setTouchPin(TOUCH_PIN);
+        CHECK(fpm.touchBegin(TOUCH_PIN));
+        fpm.onComplete(onTouchDone);
+        CHECK(fpm.beginTouchIdentify(false));
+    }
+
+    Latency latency;
+    uint64_t awakeUs = 0;
+    uint32_t frames = sim.framesReceived();
+    unsigned long lastPoll = 0;
+    uint64_t lift = 0;
+    bool present = false;
+    int k = 0, identified = 0;
+    while (k < TOUCHES) {
+        uint64_t now = hostClockMicros();
+        if (!present && now >= touchTime(k)) {
+            sim.setFinger(5);
+            present = true;
+        }
+        if (lift && now >= lift) {
+            sim.setFinger(FPM383_SIM_NO_FINGER);
+            present = false;
+            lift = 0;
+            k++;
+        }
+        uint8_t result = 0xFF;
+        if (wake) {
+            touchOp = FPM383_OP_NONE;
+            fpm.poll();
+            if (touchOp == FPM383_OP_AUTO_IDENTIFY) result = touchResult;
+        } else if (millis() - lastPoll >= 1000) {      // 每秒识别一次
+            lastPoll = millis();
+            result = fpm.identify(false);
+        }
+        if (result == 1 && present && !lift) {
+            latency.add(hostClockMicros() - touchTime(k));
+            lift = hostClockMicros() + 300000;
+            identified++;
+        }
+        delay(1);
+        if (!sim.asleep()) awakeUs += hostClockMicros() - now;    // 本轮结束时仍唤醒，整轮计为唤醒
+    }
+    CHECK(identified == TOUCHES);
+    printf("  %-32s touch->result avg %7.2fms max %7.2fms, %lu commands, awake %.1f%%\n",
+           wake ? "wake on TOUCHOUT" : "identify() every 1 s", latency.n ? latency.sum / 1000.0 / latency.n : 0.0,
+           latency.max / 1000.0, (unsigned long)(sim.framesReceived() - frames), awakeUs * 100.0 / hostClockMicros());
+    if (wake) {
+        CHECK(latency.max < 200000);
+        fpm.touchEnd();
+    }
+}
+
+// 休眠指令失败：按 FPM383_TOUCH_RETRY 间隔重试，不连续发送，lastError() 报告原因
+static void benchTouchSleepRetry()
+{
+    hostClockReset();
+    FPM383Simulator sim;
+    sim.setTouchPin(TOUCH_PIN);
+    sim.failCommand(0x33, 1000);
+    YFROBOTFPM383 fpm(&sim);
+    CHECK(fpm.touchBegin(TOUCH_PIN));
+    CHECK(fpm.beginTouchIdentify(false));
+    bool reported = false;
+    while (hostClockMicros() < 5000000ULL) {
+        fpm.poll();
+        if (fpm.lastError() == FPM383_ERROR_SLEEP) reported = true;
+        delay(1);
+    }
+    uint32_t retries = sim.commandCount(0x33);
+    CHECK(reported && !sim.asleep());
+    CHECK(retries >= 5 && retries <= 5000 / FPM383_TOUCH_RETRY + 1);
+    sim.failCommand(0x33, 0);
+    while (hostClockMicros() < 5000000ULL + FPM383_TOUCH_RETRY * 1000ULL + 100000) {
+        fpm.poll();
+        delay(1);
+    }
+    CHECK(sim.asleep() && sim.commandCount(0x33) == retries + 1);
+    printf("  %-32s %lu sleep commands in 5 s\n", "sleep failing", (unsigned long)retries);
+    fpm.touchEnd();
+}
+
+static void printStats(YFROBOTFPM383 &fpm)
+{
+    const FPM383Stats &st = fpm.stats();
+    printf("  %-6s %6s %6s %6s %6s %6s %9s %9s %9s %8s %8s\n", "opcode", "calls", "reply", "tmo", "csum",
+           "resync", "rtt min", "rtt avg", "rtt max", "tx", "rx");
+    for (uint8_t i = 0; i < st.count; i++) {
+        const FPM383OpStats &op = st.ops[i];
+        printf("  0x%02X   %6lu %6lu %6lu %6lu %6lu %7.2fms %7.2fms %7.2fms %8lu %8lu\n", op.opcode,
+               (unsigned long)op.calls, (unsigned long)op.replies, (unsigned long)op.timeouts,
+               (unsigned long)op.checksumErrors, (unsigned long)op.resyncs,
+               op.replies ? op.rttMin / 1000.0 : 0.0, op.replies ? op.rttSum / 1000.0 / op.replies : 0.0,
+               op.rttMax / 1000.0, (unsigned long)op.bytesSent, (unsigned long)op.bytesReceived);
+    }
+}
+
+static void benchDiagnostics()
+{
+    hostClockReset();
+    FPM383Simulator sim;
+    sim.setTemplate(1, 5);
+    sim.setFinger(5);
+    YFROBOTFPM383 fpm(&sim);
+
+    printf("diagnostics\n");
+    for (int i = 0; i < 10; i++) {
+        CHECK(fpm.identify(false) == 1);
+    }
+    CHECK(fpm.lastError() == FPM383_ERROR_NONE);
+    const FPM383OpStats *search = fpm.opStats(0x04);
+    CHECK(search != NULL && search->calls == 10 && search->replies == 10 && search->timeouts == 0);
+    CHECK(search != NULL && search->bytesSent == 10 * 17 && search->bytesReceived == 10 * 16);
+
+    sim.setProcessTime(0x1D, 3000000);                      // 模组无应答
+    CHECK(fpm.inquiry() == 0xFF && fpm.lastError() == FPM383_ERROR_NO_REPLY);
+    CHECK(fpm.opStats(0x1D)->timeouts == 1);
+    delay(2000);                                            // 丢弃迟到的应答
+    sim.setProcessTime(0x1D, 5000);
+
+    sim.corruptReplies(1);                                  // 应答包校验和错误
+    CHECK(fpm.getImage() == 0xFF && fpm.lastError() == FPM383_ERROR_BAD_PACKET);
+    CHECK(fpm.opStats(0x01)->checksumErrors == 1 && fpm.opStats(0x01)->resyncs == 1);
+    FPM383Response bad;
+    sim.corruptReplies(1);
+    CHECK(fpm.getImage(bad) == 0xFF && bad.error == FPM383_ERROR_BAD_PACKET && !bad.ok());
+
+    uint8_t small[100];
+    CHECK(fpm.uploadTemplate(1, small, sizeof(small), NULL) == 0xFF && fpm.lastError() == FPM383_ERROR_ABORTED);
+    CHECK(fpm.inquiry() == 1 && fpm.lastError() == FPM383_ERROR_NONE);
+    printStats(fpm);
+
+    fpm.resetStats();
+    CHECK(fpm.stats().count == 0 && fpm.opStats(0x04) == NULL);
+}
+
+static void benchCommands()
+{
+    hostClockReset();
+    FPM383Simulator sim;
+    sim.setFinger(2);
+    YFROBOTFPM383 fpm(&sim);
+
+    printf("commands\n");
+    uint64_t t0 = hostClockMicros();
+    String sn = fpm.getChipSN();
+    printf("  %-32s %8.2fms \"%s\"\n", "getChipSN", (hostClockMicros() - t0) / 1000.0, sn.c_str());
+    CHECK(sn == "FPM383SIM");
+    char buf[FPM383_CHIP_SN_LENGTH + 1], small[4];
+    CHECK(fpm.getChipSN(buf, sizeof(buf)) && sn == buf);
+    CHECK(fpm.getChipSN(small, sizeof(small)) && strcmp(small, "FPM") == 0);
+
+    t0 = hostClockMicros();
+    CHECK(fpm.enroll(4, 4) == 0x00);
+    printf("  %-32s %8.2fms\n", "enroll (4 captures)", (hostClockMicros() - t0) / 1000.0);
+    CHECK(fpm.enroll(4, 4) == 0x01);
+
+    FPM383Response count, found;                            // 每次调用的结果互不覆盖
+    CHECK(fpm.inquiry(count) == 0x00 && count.param16(0) == 1);
+    CHECK(fpm.getImage(found) == 0x00 && fpm.getChar(found) == 0x00);
+    CHECK(fpm.searchMB(found) == 0x00 && found.id == 4 && found.score > 0 && found.length == 4);
+    CHECK(count.ok() && count.param16(0) == 1 && count.id == FPM383_NO_ID);
+
+    t0 = hostClockMicros();
+    CHECK(fpm.inquiry() == 1);
+    printf("  %-32s %8.2fms\n", "inquiry", (hostClockMicros() - t0) / 1000.0);
+
+    t0 = hostClockMicros();
+    CHECK(fpm.deleteID(4) == 0x00);
+    printf("  %-32s %8.2fms\n", "deleteID", (hostClockMicros() - t0) / 1000.0);
+    CHECK(sim.templateAt(4) == -1);
+
+    sim.setTemplate(0, 1);
+    t0 = hostClockMicros();
+    CHECK(fpm.empty() == 0x00);
+    printf("  %-32s %8.2fms\n", "empty", (hostClockMicros() - t0) / 1000.0);
+    CHECK(fpm.inquiry() == 0);
+}
+
+// 分段搜索与批量删除：模组搜索时间随比对的模板数增加
+static void benchPartition()
+{
+    hostClockReset();
+    FPM383Simulator sim;
+    sim.setSearchTimePerId(2000);
+    for (uint16_t id = 0; id < 50; id++) sim.setTemplate(id, 100 + id);
+    sim.setFinger(145);
+    YFROBOTFPM383 fpm(&sim);
+    CHECK(fpm.loadIndex());
+
+    printf("partitioned search\n");
+    uint64_t t0 = hostClockMicros();
+    CHECK(fpm.identify(false) == 45);
+    printf("  %-32s %8.2fms\n", "identify (50 IDs)", (hostClockMicros() - t0) / 1000.0);
+    t0 = hostClockMicros();
+    CHECK(fpm.identify(false, 40, 10) == 45);
+    printf("  %-32s %8.2fms\n", "identify (IDs 40-49)", (hostClockMicros() - t0) / 1000.0);
+    CHECK(fpm.identify(false, 0, 40) == 0xFE);      // 其他分组的指纹不会被识别
+    uint16_t id = 0, score = 0;
+    CHECK(fpm.searchMB(40, 10, &id, &score) == 0x00 && id == 45 && score > 0);
+    CHECK(fpm.searchMB(0, 45, &id, &score) == 0x09);
+
+    t0 = hostClockMicros();
+    for (uint16_t i = 0; i < 10; i++) CHECK(fpm.deleteID(i) == 0x00);
+    uint64_t single = hostClockMicros() - t0;
+    t0 = hostClockMicros();
+    CHECK(fpm.deleteRange(10, 10) == 0x00);
+    uint64_t range = hostClockMicros() - t0;
+    printf("  %-32s %8.2fms\n", "deleteID x10", single / 1000.0);
+    printf("  %-32s %8.2fms\n", "deleteRange(10, 10)", range / 1000.0);
+    CHECK(range * 5 < single);
+    CHECK(sim.templateAt(10) < 0 && sim.templateAt(19) < 0 && sim.templateAt(20) == 120);
+    CHECK(!fpm.isEnrolled(19) && fpm.isEnrolled(20) && fpm.enrolledCount() == 30);
+}
+
+int main()
+{
+    benchIdentify(57600);
+    benchIdentify(115200);
+    benchBaud();
+    benchTemplates(57600);
+    benchTemplates(115200);
+    benchSysPara();
+    benchImage(57600);
+    benchImage(115200);
+    benchIndex();
+    benchPartition();
+    benchTemplateStore();
+    benchAsync();
+    printf("scheduler identify\n");
+    uint32_t one = benchScheduler(1);
+    uint32_t two = benchScheduler(2);
+    uint32_t four = benchScheduler(4);
+    CHECK(two >= one * 18 / 10);
+    CHECK(four >= one * 35 / 10);
+    benchWorker();
+    benchPipeline();
+    benchResync();
+    benchDiagnostics();
+    benchEnrollProgress();
+    printf("touch wake (%d touches)\n", TOUCHES);
+    benchTouch(false);
+    benchTouch(true);
+    benchTouchSleepRetry();
+    benchCommands();
+    printf("%s (%d failures)\n", failures ? "FAILED" : "OK", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,315 @@
+/******************************************************************************
+  fpm383_power_benchmark.cpp
+  YFROBOT FPM383 Sensor Library Linux host power benchmark
+  Update Date: 04-11-2024
+  @ YFROBOT
+
+  识别循环的功耗/占空比对比：在模拟器上按三种手指到达模式（稀疏、繁忙、成组）各运行30分钟虚拟时间，
+  比较以下识别策略的模组唤醒时间占比、收发帧数及字节数、每次手指事件的识别尝试次数、漏识别与响应延迟：
+    1. Example04：identify(false) 后 delay(N)，N = 250/500/1000/2000 ms，模组一直唤醒；
+    2. identify(false) 后 sleep()，再 delay(1000)，下一次识别指令唤醒模组；
+    3. Example09：touchBegin() + beginTouchIdentify()，每5 ms 调用一次 poll()。
+  功耗数据由 powerStats() 统计，并与模拟器的收发计数、休眠状态校验。
+
+  任一检查失败时返回非零值。
+
+  Distributed as-is; no warranty is given.
+******************************************************************************/
+
+#include <stdio.h>
+#include "yfrobot_fpm383.h"
+#include "fpm383_simulator.h"
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+#define RUN_US          (30ULL * 60 * 1000000)  // 每个模式运行30分钟
+#define FINGER          5                       // 手指编号，已注册为 FINGER_ID
+#define FINGER_ID       1
+#define SERVED_LIFT_US  300000                  // 识别成功 300 ms 后抬起手指
+#define TOUCH_PIN       2
+#define TOUCH_POLL_MS   5
+
+#if !FPM383_POWER
+#error "fpm383_power_benchmark requires FPM383_POWER"
+#endif
+
+enum Mode { MODE_POLL, MODE_POLL_SLEEP, MODE_TOUCH };
+
+struct Strategy {
+    const char *name;
+    Mode mode;
+    unsigned long interval;     // ms
+};
+
+static const Strategy strategies[] = {
+    { "identify + delay(250)",   MODE_POLL,       250 },
+    { "identify + delay(500)",   MODE_POLL,       500 },
+    { "identify + delay(1000)",  MODE_POLL,       1000 },
+    { "identify + delay(2000)",  MODE_POLL,       2000 },
+    { "identify + sleep + 1000", MODE_POLL_SLEEP, 1000 },
+    { "touch wake",              MODE_TOUCH,      TOUCH_POLL_MS },
+};
+#define STRATEGIES (sizeof(strategies) / sizeof(strategies[0]))
+#define POLL_1000   2           // 对比基准：Example04 推荐的每秒识别一次
+
+// 手指到达：arrival 时按下，最长按住 hold
+struct Arrival {
+    uint64_t arrival;
+    uint64_t hold;
+};
+
+struct Pattern {
+    const char *name;
+    std::vector<Arrival> arrivals;
+};
+
+static uint32_t lcg = 1;
+
+static uint32_t nextRandom(uint32_t range)
+{
+    lcg = lcg * 1103515245u + 12345u;
+    return (lcg >> 8) % range;
+}
+
+// 相邻两次到达之间至少间隔 hold + 3 s，保证最慢的策略也能在两次到达之间完成一次无手指的识别
+static Pattern makePattern(const char *name, uint32_t meanGapMs, uint32_t holdMs, uint8_t group, uint32_t seed)
+{
+    Pattern p;
+    p.name = name;
+    lcg = seed;
+    uint64_t t = 5000000;
+    while (true) {
+        uint32_t gap = group > 1 ? 60000 + nextRandom(120000) : holdMs + 3000 + nextRandom(2 * (meanGapMs - holdMs - 3000));
+        t += gap * 1000ULL;
+        for (uint8_t i = 0; i < group; i++) {
+            uint64_t at = t + i * 4000000ULL;
+            if (at + 10000000ULL >= RUN_US) return p;
+            Arrival a = { at, holdMs * 1000ULL };
+            p.arrivals.push_back(a);
+        }
+        t += (group - 1) * 4000000ULL;
+    }
+}
+
+struct Result {
+    double awake;               // 模组唤醒时间占比（%），powerStats()
+    double simAwake;            // 模拟器休眠状态统计的唤醒时间占比（%）
+    uint32_t frames;            // 收发帧数
+    uint32_t bytes;             // 收发字节数
+    uint32_t attempts;
+    uint32_t fingerAttempts;
+    uint32_t events;
+    uint32_t served;
+    uint32_t missed;
+    uint64_t latencySum;
+    uint64_t latencyMax;
+};
+
+// 模拟手指：按到达时间按下，识别成功后或按住时间结束时抬起
+class FingerModel
+{
+  public:
+    FingerModel(FPM383Simulator &sim, const Pattern &pattern)
+        : _sim(sim), _pattern(pattern), _k(0), _present(false), _lift(0),
+          _served(pattern.arrivals.size(), false), _latencySum(0), _latencyMax(0) {}
+
+    // 更新当前时刻的手指状态
+    void update()
+    {
+        uint64_t now = hostClockMicros();
+        if (_present && now >= _lift) {
+            _sim.setFinger(FPM383_SIM_NO_FINGER);
+            _present = false;
+            _k++;
+        }
+        if (!_present && _k < _pattern.arrivals.size() && now >= _pattern.arrivals[_k].arrival) {
+            _sim.setFinger(FINGER);
+            _present = true;
+            _lift = _pattern.arrivals[_k].arrival + _pattern.arrivals[_k].hold;
+        }
+    }
+
+    // 下一次手指状态变化的时刻
+    uint64_t next() const
+    {
+        if (_present) return _lift;
+        return _k < _pattern.arrivals.size() ? _pattern.arrivals[_k].arrival : ~0ULL;
+    }
+
+    // 识别成功：手指按下时为当前到达；自动验证在手指抬起前已采图时为上一次到达
+    void identified()
+    {
+        size_t k = _present ? _k : _k - 1;
+        if (!_present && _k == 0) return;
+        if (_served[k]) return;
+        _served[k] = true;
+        uint64_t latency = hostClockMicros() - _pattern.arrivals[k].arrival;
+        _latencySum += latency;
+        if (latency > _latencyMax) _latencyMax = latency;
+        if (_present) {
+            uint64_t lift = hostClockMicros() + SERVED_LIFT_US;
+            if (lift < _lift) _lift = lift;
+        }
+    }
+
+    uint32_t served() const
+    {
+        uint32_t n = 0;
+        for (size_t i = 0; i < _served.size(); i++) n += _served[i];
+        return n;
+    }
+    uint64_t latencySum() const { return _latencySum; }
+    uint64_t latencyMax() const { return _latencyMax; }
+
+  private:
+    FPM383Simulator &_sim;
+    const Pattern &_pattern;
+    size_t _k;
+    bool _present;
+    uint64_t _lift;
+    std::vector<bool> _served;
+    uint64_t _latencySum;
+    uint64_t _latencyMax;
+};
+
+static uint8_t touchOp = FPM383_OP_NONE;
+static uint8_t touchResult = 0xFF;
+
+static void onTouchDone(YFROBOTFPM383 *fpm, uint8_t op, uint8_t result)
+{
+    (void)fpm;
+    touchOp = op;
+    touchResult = result;
+}
+
+// 等待 us 微秒，期间按时更新手指状态
+static void wait(FingerModel &finger, uint64_t us)
+{
+    uint64_t end = hostClockMicros() + us;
+    while (hostClockMicros() < end) {
+        uint64_t next = finger.next();
+        uint64_t to = next < end ? next : end;
+        if (to > hostClockMicros()) hostClockAdvance(to - hostClockMicros());
+        finger.update();
+    }
+}
+
+static Result run(const Strategy &strategy, const Pattern &pattern)
+{
+    hostClockReset();
+    hostClockSetStep(10);               // 忙等循环每次推进 10 us，功耗按 ms 统计，不影响结果
+    FPM383Simulator sim;
+    sim.setTemplate(FINGER_ID, FINGER);
+    YFROBOTFPM383 fpm(&sim);
+    CHECK(fpm.begin());
+    if (strategy.mode == MODE_TOUCH) {
+        sim.setTouchPin(TOUCH_PIN);
+        CHECK(fpm.touchBegin(TOUCH_PIN));
+        fpm.onComplete(onTouchDone);
+        CHECK(fpm.beginTouchIdentify(false));
+    }
+    fpm.resetPowerStats();
+    uint32_t simFrames = sim.framesReceived();
+    uint32_t simRx = sim.bytesReceived();
+    uint32_t simTx = sim.bytesSent();
+    uint64_t start = hostClockMicros();
+    uint64_t simAwakeUs = 0;
+
+    FingerModel finger(sim, pattern);
+    while (hostClockMicros() - start < RUN_US) {
+        finger.update();
+        bool asleep = sim.asleep();
+        uint64_t t0 = hostClockMicros();
+        uint8_t result = 0xFF;
+        if (strategy.mode == MODE_TOUCH) {
+            touchOp = FPM383_OP_NONE;
+            fpm.poll();
+            if (touchOp == FPM383_OP_AUTO_IDENTIFY) result = touchResult;
+        } else {
+            result = fpm.identify(false);
+        }
+        uint64_t t1 = hostClockMicros();
+        if (!asleep || !sim.asleep()) simAwakeUs += t1 - t0;
+        if (strategy.mode == MODE_POLL_SLEEP) {
+            fpm.sleep();                // 发送休眠指令期间模组唤醒
+            simAwakeUs += hostClockMicros() - t1;
+            t1 = hostClockMicros();
+        }
+        if (result == FINGER_ID) finger.identified();
+        asleep = sim.asleep();
+        wait(finger, strategy.interval * 1000ULL);
+        if (!asleep) simAwakeUs += hostClockMicros() - t1;
+    }
+    if (strategy.mode == MODE_TOUCH) fpm.touchEnd();
+    CHECK(fpm.inquiry() == 1);          // 处理完流水线指令的应答后再比较收发计数
+    hostClockSetStep(1);
+
+    const FPM383PowerStats &st = fpm.powerStats();
+    uint32_t framesSent = 0, framesReceived = 0, bytesSent = 0, bytesReceived = 0;
+    for (uint8_t i = 0; i < FPM383_POWER_OPS; i++) {
+        framesSent += st.ops[i].framesSent;
+        framesReceived += st.ops[i].framesReceived;
+        bytesSent += st.ops[i].bytesSent;
+        bytesReceived += st.ops[i].bytesReceived;
+    }
+    CHECK(framesSent == sim.framesReceived() - simFrames);
+    CHECK(bytesSent == sim.bytesReceived() - simRx);
+    CHECK(bytesReceived == sim.bytesSent() - simTx);
+    CHECK(st.identifyAttempts == st.ops[FPM383_OP_IDENTIFY].count + st.ops[FPM383_OP_AUTO_IDENTIFY].count);
+    CHECK(st.fingerAttempts <= st.identifyAttempts);
+
+    Result r;
+    uint64_t total = (uint64_t)st.awakeMillis + st.sleepMillis;
+    r.awake = total ? st.awakeMillis * 100.0 / total : 0.0;
+    r.simAwake = simAwakeUs * 100.0 / (hostClockMicros() - start);
+    r.frames = framesSent + framesReceived;
+    r.bytes = bytesSent + bytesReceived;
+    r.attempts = st.identifyAttempts;
+    r.fingerAttempts = st.fingerAttempts;
+    r.events = st.fingerEvents;
+    r.served = finger.served();
+    r.missed = pattern.arrivals.size() - r.served;
+    r.latencySum = finger.latencySum();
+    r.latencyMax = finger.latencyMax();
+    return r;
+}
+
+static void benchPattern(const Pattern &pattern)
+{
+    size_t arrivals = pattern.arrivals.size();
+    double hours = RUN_US / 3600e6;
+    printf("%s: %lu finger arrivals in %lu min\n", pattern.name, (unsigned long)arrivals,
+           (unsigned long)(RUN_US / 60000000));
+    printf("  %-24s %7s %9s %10s %8s %7s %6s %10s %10s\n", "strategy", "awake", "frames/h", "bytes/h",
+           "att/evt", "events", "missed", "lat avg", "lat max");
+    Result results[STRATEGIES];
+    for (size_t i = 0; i < STRATEGIES; i++) {
+        Result &r = results[i];
+        r = run(strategies[i], pattern);
+        printf("  %-24s %6.2f%% %9.0f %10.0f %8.1f %7lu %6lu %8.1fms %8.1fms\n", strategies[i].name, r.awake,
+               r.frames / hours, r.bytes / hours, r.events ? (double)r.attempts / r.events : 0.0,
+               (unsigned long)r.events, (unsigned long)r.missed,
+               r.served ? r.latencySum / 1000.0 / r.served : 0.0, r.latencyMax / 1000.0);
+        CHECK(r.awake - r.simAwake < 1.0 && r.simAwake - r.awake < 1.0);
+        CHECK(r.events == r.served);    // 每次被识别的到达恰好计为一次手指事件
+    }
+    const Result &touch = results[STRATEGIES - 1];
+    const Result &poll = results[POLL_1000];
+    CHECK(touch.missed == 0);
+    CHECK(touch.events == arrivals);
+    CHECK(touch.awake < poll.awake);
+    CHECK(touch.frames < poll.frames);
+    CHECK(results[0].awake == 100.0);   // 不休眠的轮询一直唤醒
+}
+
+int main()
+{
+    benchPattern(makePattern("sparse (mean 120 s, hold 1 s)", 120000, 1000, 1, 1));
+    benchPattern(makePattern("busy (mean 15 s, hold 0.8 s)", 15000, 800, 1, 2));
+    benchPattern(makePattern("burst (5 x 4 s, hold 0.8 s)", 0, 800, 5, 3));
+    printf("%s (%d failures)\n", failures ? "FAILED" : "OK", failures);
+    return failures ? 1 : 0;
+}
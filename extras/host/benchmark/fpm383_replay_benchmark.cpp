@@ -0,0 +1,349 @@
+/******************************************************************************
+  fpm383_replay_benchmark.cpp
+  YFROBOT FPM383 Sensor Library Linux host replay benchmark
+  Update Date: 04-11-2024
+  @ YFROBOT
+
+  用 FPM383TraceTransport 记录模拟器上的一组典型会话，作为记录语料：
+    1. 回放：同一会话在虚拟时钟下回放，结果、发送内容须与记录时完全一致，输出各指令往返延迟；
+    2. 解析吞吐量：语料中的接收字节直接送入帧解析器；
+    3. 模糊测试：变异语料（位翻转、丢字节、噪声、截断、延迟）后回放，结果只能与记录相同或为失败值，
+       不能得到错误的成功结果；统计帧解析器能否在会话末尾的查询指令之前重新同步。
+  命令行参数为其他记录文件（如在设备上采集的 .fpt）时，对其进行解析统计；-o 目录 保存生成的语料。
+
+  任一检查失败时返回非零值。
+
+  Distributed as-is; no warranty is given.
+******************************************************************************/
+
+#include <stdio.h>
+#include "yfrobot_fpm383.h"
+#include "fpm383_simulator.h"
+#include "fpm383_replay.h"
+#include <chrono>
+#include <string.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+#define FUZZ_SEEDS      60      // 每条语料的变异次数
+#define RESULT_FAILED   0xFF    // 会话结果中的失败值
+
+// 会话：sim 仅在记录时非 NULL，用于设置模拟器；结果写入 results，失败统一为 RESULT_FAILED
+typedef void (*Session)(YFROBOTFPM383 &fpm, FPM383Simulator *sim, std::vector<uint32_t> &results);
+
+static uint32_t checksum(const uint8_t *data, uint32_t length)
+{
+    uint32_t sum = 2166136261u;
+    for (uint32_t i = 0; i < length; i++) sum = (sum ^ data[i]) * 16777619u;
+    return sum & 0x7FFFFFFF;
+}
+
+static void sessionIdentify(YFROBOTFPM383 &fpm, FPM383Simulator *sim, std::vector<uint32_t> &results)
+{
+    if (sim) {
+        sim->setTemplate(3, 7);
+        sim->setFinger(7);
+    }
+    results.push_back(fpm.identify(false));
+    results.push_back(fpm.identify(false, 10, 10));     // 该段中没有此指纹
+    if (sim) sim->setFinger(FPM383_SIM_NO_FINGER);
+    results.push_back(fpm.identify(true));
+}
+
+static void sessionAutoIdentify(YFROBOTFPM383 &fpm, FPM383Simulator *sim, std::vector<uint32_t> &results)
+{
+    if (sim) {
+        sim->setTemplate(4, 9);
+        sim->setFinger(9);
+    }
+    results.push_back(fpm.autoIdentify(false));
+    results.push_back(fpm.autoIdentify(false, FPM383_SECURITY_DEFAULT, 4));
+}
+
+static void sessionEnroll(YFROBOTFPM383 &fpm, FPM383Simulator *sim, std::vector<uint32_t> &results)
+{
+    if (sim) sim->setFinger(12);
+    results.push_back(fpm.enroll(5, 4));
+    results.push_back(fpm.enroll(5, 4));                // 该ID已注册
+}
+
+static void sessionTemplate(YFROBOTFPM383 &fpm, FPM383Simulator *sim, std::vector<uint32_t> &results)
+{
+    if (sim) sim->setTemplate(2, 11);
+    static uint8_t buffer[2048];
+    uint32_t length = 0;
+    uint8_t code = fpm.uploadTemplate(2, buffer, sizeof(buffer), &length);
+    results.push_back(code);
+    results.push_back(code == 0x00 ? checksum(buffer, length) : RESULT_FAILED);
+    results.push_back(code == 0x00 ? fpm.downloadTemplate(8, buffer, length) : RESULT_FAILED);
+}
+
+static void sessionIndex(YFROBOTFPM383 &fpm, FPM383Simulator *sim, std::vector<uint32_t> &results)
+{
+    if (sim) {
+        sim->setTemplate(0, 1);
+        sim->setTemplate(1, 2);
+        sim->setTemplate(6, 3);
+    }
+    bool ok = fpm.loadIndex();
+    results.push_back(ok ? 0x00 : RESULT_FAILED);
+    results.push_back(ok ? fpm.nextFreeId() : RESULT_FAILED);
+    results.push_back(fpm.deleteRange(0, 2));
+}
+
+static void sessionNoise(YFROBOTFPM383 &fpm, FPM383Simulator *sim, std::vector<uint32_t> &results)
+{
+    if (sim) {
+        static const uint8_t noise[] = { 0xEF, 0x01, 0x55, 0xEF, 0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x07, 0x7F };
+        sim->setTemplate(3, 7);
+        sim->setFinger(7);
+        sim->setBurst(5, 3000);
+        sim->injectNoise(noise, sizeof(noise));
+    }
+    results.push_back(fpm.identify(false));
+    if (sim) sim->corruptReplies(1);
+    results.push_back(fpm.inquiry());                   // 应答校验和错误
+    results.push_back(fpm.inquiry());
+}
+
+static void sessionImage(YFROBOTFPM383 &fpm, FPM383Simulator *sim, std::vector<uint32_t> &results)
+{
+    if (sim) sim->setFinger(5);
+    static uint8_t image[FPM383_IMAGE_SIZE];
+    uint32_t length = 0;
+    results.push_back(fpm.getImage());
+    uint8_t code = fpm.upImage(image, sizeof(image), &length);
+    results.push_back(code);
+    results.push_back(code == 0x00 ? checksum(image, length) : RESULT_FAILED);
+}
+
+struct Trace
+{
+    const char *name;
+    Session session;
+    std::vector<uint8_t> log;
+    std::vector<FPM383TraceEvent> events;
+    std::vector<uint32_t> results;      // 最后一项为会话末尾查询指令的结果
+    size_t probe;                       // 查询指令之前的记录数，模糊测试只变异此前的记录
+};
+
+static Trace corpus[] = {
+    { "identify", sessionIdentify, {}, {}, {}, 0 },
+    { "autoIdentify", sessionAutoIdentify, {}, {}, {}, 0 },
+    { "enroll", sessionEnroll, {}, {}, {}, 0 },
+    { "template", sessionTemplate, {}, {}, {}, 0 },
+    { "index", sessionIndex, {}, {}, {}, 0 },
+    { "noise", sessionNoise, {}, {}, {}, 0 },
+    { "image", sessionImage, {}, {}, {}, 0 },
+};
+static const size_t CORPUS = sizeof(corpus) / sizeof(corpus[0]);
+
+static void record(Trace &t)
+{
+    hostClockReset();
+    FPM383Simulator sim;
+    FPM383TraceBuffer log;
+    FPM383TraceTransport trace(&sim, log);
+    YFROBOTFPM383 fpm(&trace);
+    t.session(fpm, &sim, t.results);
+    std::vector<FPM383TraceEvent> before;
+    fpm383DecodeTrace(log.data, before);
+    t.probe = before.size();
+    t.results.push_back(fpm.inquiry());
+    t.log = log.data;
+    CHECK(fpm383DecodeTrace(t.log, t.events));
+}
+
+// 回放会话，stats 非 NULL 时累加各指令统计
+static void replay(const Trace &t, const std::vector<FPM383TraceEvent> &events, std::vector<uint32_t> &results,
+                   FPM383ReplayTransport **transport, FPM383Stats *stats)
+{
+    hostClockReset();
+    FPM383ReplayTransport *rt = new FPM383ReplayTransport(events);
+    YFROBOTFPM383 fpm(rt);
+    t.session(fpm, NULL, results);
+    results.push_back(fpm.inquiry());
+    if (stats != NULL) {
+        const FPM383Stats &s = fpm.stats();
+        for (uint8_t i = 0; i < s.count; i++) {
+            uint8_t k = 0;
+            while (k < stats->count && stats->ops[k].opcode != s.ops[i].opcode) k++;
+            if (k == stats->count) {
+                if (k == FPM383_STATS_OPS) continue;
+                stats->ops[k] = s.ops[i];
+                stats->count++;
+                continue;
+            }
+            FPM383OpStats &op = stats->ops[k];
+            op.calls += s.ops[i].calls;
+            op.replies += s.ops[i].replies;
+            op.rttSum += s.ops[i].rttSum;
+            if (s.ops[i].rttMin < op.rttMin) op.rttMin = s.ops[i].rttMin;
+            if (s.ops[i].rttMax > op.rttMax) op.rttMax = s.ops[i].rttMax;
+        }
+    }
+    *transport = rt;
+}
+
+static void benchReplay()
+{
+    printf("replay (%u traces)\n", (unsigned)CORPUS);
+    FPM383Stats stats;
+    memset(&stats, 0, sizeof(stats));
+    for (size_t i = 0; i < CORPUS; i++) {
+        std::vector<uint32_t> results;
+        FPM383ReplayTransport *rt;
+        replay(corpus[i], corpus[i].events, results, &rt, &stats);
+        CHECK(results == corpus[i].results);
+        CHECK(rt->txMismatches() == 0 && rt->finished());
+        printf("  %-14s %6u events %7u bytes log, %u results %s\n", corpus[i].name, (unsigned)corpus[i].events.size(),
+               (unsigned)corpus[i].log.size(), (unsigned)results.size(),
+               results == corpus[i].results ? "match" : "DIFFER");
+        delete rt;
+    }
+    printf("  %-6s %6s %9s %9s %9s\n", "opcode", "calls", "rtt min", "rtt avg", "rtt max");
+    for (uint8_t i = 0; i < stats.count; i++) {
+        const FPM383OpStats &op = stats.ops[i];
+        if (op.replies == 0) continue;
+        printf("  0x%02X   %6lu %7.2fms %7.2fms %7.2fms\n", op.opcode, (unsigned long)op.calls,
+               op.rttMin / 1000.0, op.rttSum / 1000.0 / op.replies, op.rttMax / 1000.0);
+    }
+}
+
+static void reportParse(const char *name, const std::vector<FPM383TraceEvent> &events, FPM383ParseResult *total)
+{
+    FPM383Simulator idle;
+    YFROBOTFPM383 fpm(&idle);
+    FPM383ParseResult r = FPM383Replay::parse(fpm, events);
+    printf("  %-14s %7u bytes %5u frames %4u errors\n", name, (unsigned)r.bytes, (unsigned)r.frames, (unsigned)r.errors);
+    if (total != NULL) {
+        total->bytes += r.bytes;
+        total->frames += r.frames;
+        total->errors += r.errors;
+    }
+}
+
+static void benchParse()
+{
+    printf("frame parser\n");
+    FPM383ParseResult total = { 0, 0, 0, 0 };
+    for (size_t i = 0; i < CORPUS; i++) reportParse(corpus[i].name, corpus[i].events, &total);
+    CHECK(total.frames > 0);
+
+    // 伪包头的包长度恰好吞掉紧随其后的两个应答包：重新同步后两个应答都要解析出来
+    static const uint8_t swallowed[] = {
+        0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x07, 0x00, 0x18,
+        0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x07, 0x00, 0x03, 0x00, 0x00, 0x0A,
+        0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x07, 0x00, 0x03, 0x01, 0x00, 0x0B,
+    };
+    std::vector<FPM383TraceEvent> noisy;
+    for (size_t i = 0; i < sizeof(swallowed); i++) {
+        FPM383TraceEvent e = { i, FPM383_TRACE_RX, std::vector<uint8_t>(1, swallowed[i]) };
+        noisy.push_back(e);
+    }
+    FPM383Simulator none;
+    YFROBOTFPM383 parser(&none);
+    FPM383ParseResult r = FPM383Replay::parse(parser, noisy);
+    CHECK(r.frames == 2 && r.errors == 1 && r.lastFrameEnd == r.bytes);
+
+    FPM383Simulator idle;
+    YFROBOTFPM383 fpm(&idle);
+    uint64_t bytes = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int round = 0; round < 20; round++) {
+        for (size_t i = 0; i < CORPUS; i++) bytes += FPM383Replay::parse(fpm, corpus[i].events).bytes;
+    }
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    printf("  %-14s %.1f MB/s (%llu bytes in %.1f ms)\n", "throughput", bytes / s / 1e6,
+           (unsigned long long)bytes, s * 1000);
+}
+
+static void benchFuzz()
+{
+    static const char *kinds[FPM383_MUTATE_KINDS] = { "flip", "drop", "noise", "truncate", "delay" };
+    uint32_t runs[FPM383_MUTATE_KINDS] = { 0 }, wrong[FPM383_MUTATE_KINDS] = { 0 };
+    uint32_t recovered[FPM383_MUTATE_KINDS] = { 0 }, failed[FPM383_MUTATE_KINDS] = { 0 };
+    FPM383Simulator sim;
+    YFROBOTFPM383 idle(&sim);
+
+    for (size_t i = 0; i < CORPUS; i++) {
+        const Trace &t = corpus[i];
+        uint32_t seeds = strcmp(t.name, "image") == 0 ? FUZZ_SEEDS / 6 : FUZZ_SEEDS;
+        for (uint32_t seed = 1; seed <= seeds; seed++) {
+            std::vector<FPM383TraceEvent> events = t.events;
+            uint8_t kind = fpm383MutateTrace(events, t.probe, seed * 31 + i);
+            std::vector<uint32_t> results;
+            FPM383ReplayTransport *rt;
+            replay(t, events, results, &rt, NULL);
+            delete rt;
+            runs[kind]++;
+            bool ok = results.size() == t.results.size();
+            bool anyFailed = false;
+            for (size_t k = 0; ok && k < results.size(); k++) {
+                if (results[k] == t.results[k]) continue;
+                if (results[k] == RESULT_FAILED) {
+                    anyFailed = true;
+                    continue;
+                }
+                ok = false;                                     // 得到了与记录不同的成功结果
+            }
+            if (!ok) {
+                wrong[kind]++;
+                printf("  wrong result: %s seed %u (%s)\n", t.name, (unsigned)seed, kinds[kind]);
+            }
+            if (anyFailed) failed[kind]++;
+            FPM383ParseResult r = FPM383Replay::parse(idle, events);
+            if (r.lastFrameEnd == r.bytes) recovered[kind]++;   // 变异之后解析器重新同步，末尾查询指令的应答解析正确
+        }
+    }
+
+    printf("fuzzed replay\n");
+    printf("  %-10s %6s %8s %8s %10s\n", "mutation", "runs", "failed", "wrong", "recovered");
+    uint32_t totalRuns = 0, totalWrong = 0, totalRecovered = 0;
+    for (uint8_t k = 0; k < FPM383_MUTATE_KINDS; k++) {
+        printf("  %-10s %6u %8u %8u %9.1f%%\n", kinds[k], (unsigned)runs[k], (unsigned)failed[k], (unsigned)wrong[k],
+               runs[k] ? recovered[k] * 100.0 / runs[k] : 0.0);
+        totalRuns += runs[k];
+        totalWrong += wrong[k];
+        totalRecovered += recovered[k];
+    }
+    CHECK(totalWrong == 0);
+    CHECK(totalRecovered * 10 >= totalRuns * 9);        // 至少90%在末尾之前重新同步
+}
+
+int main(int argc, char **argv)
+{
+    const char *outDir = NULL;
+    int first = 1;
+    if (argc > 2 && strcmp(argv[1], "-o") == 0) {
+        outDir = argv[2];
+        first = 3;
+    }
+
+    for (size_t i = 0; i < CORPUS; i++) {
+        record(corpus[i]);
+        if (outDir != NULL) {
+            char path[256];
+            snprintf(path, sizeof(path), "%s/%s.fpt", outDir, corpus[i].name);
+            CHECK(fpm383SaveTrace(path, corpus[i].log));
+        }
+    }
+    benchReplay();
+    benchParse();
+    benchFuzz();
+
+    if (first < argc) printf("trace files\n");
+    for (int i = first; i < argc; i++) {
+        std::vector<uint8_t> log;
+        std::vector<FPM383TraceEvent> events;
+        if (!fpm383LoadTrace(argv[i], log) || !fpm383DecodeTrace(log, events)) {
+            printf("  %s: not a complete trace (%u events decoded)\n", argv[i], (unsigned)events.size());
+        }
+        reportParse(argv[i], events, NULL);
+    }
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "OK", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,71 @@
+/******************************************************************************
+  fpm383_file_storage.cpp
+  YFROBOT FPM383 Sensor Library Linux host file storage
+  Update Date: 04-11-2024
+  @ YFROBOT
+
+  Distributed as-is; no warranty is given.
+******************************************************************************/
+
+#include "fpm383_file_storage.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+FPM383FileStorage::FPM383FileStorage(const char *dir) : _dir(dir)
+{
+}
+
+std::string FPM383FileStorage::path(uint16_t user) const
+{
+    char name[16];
+    snprintf(name, sizeof(name), "/%u.tpl", (unsigned)user);
+    return _dir + name;
+}
+
+bool FPM383FileStorage::load(uint16_t user, uint8_t *buffer, uint32_t capacity, uint32_t *length)
+{
+    FILE *f = fopen(path(user).c_str(), "rb");
+    if (f == NULL) return false;
+    size_t n = fread(buffer, 1, capacity, f);
+    bool ok = !ferror(f) && fgetc(f) == EOF;   // 文件大于缓冲区视为失败
+    fclose(f);
+    if (ok && length != NULL) *length = n;
+    return ok;
+}
+
+bool FPM383FileStorage::save(uint16_t user, const uint8_t *buffer, uint32_t length)
+{
+    mkdir(_dir.c_str(), 0755);
+    std::string p = path(user);
+    std::string tmp = p + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "wb");
+    if (f == NULL) return false;
+    bool ok = fwrite(buffer, 1, length, f) == length;
+    ok = fclose(f) == 0 && ok;
+    if (ok) ok = rename(tmp.c_str(), p.c_str()) == 0;  // 写完再替换，断电不会留下半个模板
+    if (!ok) unlink(tmp.c_str());
+    return ok;
+}
+
+bool FPM383FileStorage::remove(uint16_t user)
+{
+    return unlink(path(user).c_str()) == 0;
+}
+
+bool FPM383FileStorage::list(FPM383UserCallback callback, void *context)
+{
+    DIR *d = opendir(_dir.c_str());
+    if (d == NULL) return true;     // 目录不存在，尚无用户
+    for (struct dirent *e = readdir(d); e != NULL; e = readdir(d)) {
+        char *end;
+        unsigned long user = strtoul(e->d_name, &end, 10);
+        if (end == e->d_name || strcmp(end, ".tpl") != 0 || user >= FPM383_STORE_UNKNOWN) continue;
+        if (!callback(context, (uint16_t)user)) break;
+    }
+    closedir(d);
+    return true;
+}
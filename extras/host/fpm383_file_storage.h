@@ -0,0 +1,32 @@
+/******************************************************************************
+  fpm383_file_storage.h
+  YFROBOT FPM383 Sensor Library Linux host file storage
+  Update Date: 04-11-2024
+  @ YFROBOT
+
+  FPM383TemplateStorage 的 POSIX 文件实现：dir 目录下每个用户一个文件 "<user>.tpl"。
+
+  Distributed as-is; no warranty is given.
+******************************************************************************/
+
+#ifndef FPM383_FILE_STORAGE_H
+#define FPM383_FILE_STORAGE_H
+
+#include "fpm383_template_store.h"
+#include <string>
+
+class FPM383FileStorage : public FPM383TemplateStorage
+{
+  public:
+    FPM383FileStorage(const char *dir);
+    bool load(uint16_t user, uint8_t *buffer, uint32_t capacity, uint32_t *length);
+    bool save(uint16_t user, const uint8_t *buffer, uint32_t length);
+    bool remove(uint16_t user);
+    bool list(FPM383UserCallback callback, void *context);
+
+  private:
+    std::string _dir;
+    std::string path(uint16_t user) const;
+};
+
+#endif // FPM383_FILE_STORAGE_H
@@ -0,0 +1,84 @@
+/******************************************************************************
+  fpm383_pgm.cpp
+  YFROBOT FPM383 Sensor Library Linux host PGM image writer
+  Update Date: 04-11-2024
+  @ YFROBOT
+
+  Distributed as-is; no warranty is given.
+******************************************************************************/
+
+#include "fpm383_pgm.h"
+
+bool fpm383WritePGM(const char *path, const uint8_t *image, uint16_t width, uint16_t height)
+{
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) return false;
+    uint32_t size = (uint32_t)width * height;
+    bool ok = fprintf(f, "P5\n%u %u\n255\n", (unsigned)width, (unsigned)height) > 0;
+    ok = ok && fwrite(image, 1, size, f) == size;
+    return fclose(f) == 0 && ok;
+}
+
+FPM383PGMWriter::FPM383PGMWriter() : _file(NULL), _size(0), _written(0), _ok(false)
+{
+}
+
+FPM383PGMWriter::~FPM383PGMWriter()
+{
+    close();
+}
+
+/**
+  * @brief   创建文件并写入 PGM 文件头
+  * @return  true：成功
+  */
+bool FPM383PGMWriter::open(const char *path, uint16_t width, uint16_t height)
+{
+    close();
+    _file = fopen(path, "wb");
+    if (_file == NULL) return false;
+    _size = (uint32_t)width * height;
+    _written = 0;
+    _ok = fprintf(_file, "P5\n%u %u\n255\n", (unsigned)width, (unsigned)height) > 0;
+    return _ok;
+}
+
+FPM383DataSink FPM383PGMWriter::sink()
+{
+    FPM383DataSink sink = { NULL, 0, write, this, 0, NULL };
+    return sink;
+}
+
+bool FPM383PGMWriter::write(void *context, const uint8_t *data, uint16_t length)
+{
+    FPM383PGMWriter *w = (FPM383PGMWriter *)context;
+    if (w->_file == NULL || w->_written + length > w->_size) return false;     // 超出图像大小，中止上传
+    if (fwrite(data, 1, length, w->_file) != length) w->_ok = false;
+    w->_written += length;
+    return w->_ok;
+}
+
+uint32_t FPM383PGMWriter::drain(FPM383RingBuffer &ring)
+{
+    uint8_t chunk[256];
+    uint32_t total = 0;
+    uint32_t n;
+    while ((n = ring.read(chunk, sizeof(chunk))) > 0) {
+        if (!write(this, chunk, n)) _ok = false;
+        total += n;
+    }
+    return total;
+}
+
+bool FPM383PGMWriter::close()
+{
+    if (_file == NULL) return false;
+    bool ok = fclose(_file) == 0 && _ok && _written == _size;
+    _file = NULL;
+    return ok;
+}
+
+uint32_t FPM383PGMWriter::written()
+{
+    return _written;
+}
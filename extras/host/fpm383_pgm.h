@@ -0,0 +1,43 @@
+/******************************************************************************
+  fpm383_pgm.h
+  YFROBOT FPM383 Sensor Library Linux host PGM image writer
+  Update Date: 04-11-2024
+  @ YFROBOT
+
+  将 upImage() 上传的原始指纹图像保存为 PGM（P5，8位灰度）文件，可用常见看图软件打开。
+  FPM383PGMWriter 作为接收端回调或环形缓冲区的读取方，上传时逐块写入文件，不需要整幅图像的缓冲区。
+
+  Distributed as-is; no warranty is given.
+******************************************************************************/
+
+#ifndef FPM383_PGM_H
+#define FPM383_PGM_H
+
+#include "yfrobot_fpm383.h"
+#include <stdio.h>
+
+// 整幅图像写入 PGM 文件
+bool fpm383WritePGM(const char *path, const uint8_t *image,
+                    uint16_t width = FPM383_IMAGE_WIDTH, uint16_t height = FPM383_IMAGE_HEIGHT);
+
+class FPM383PGMWriter
+{
+  public:
+    FPM383PGMWriter();
+    ~FPM383PGMWriter();
+    bool open(const char *path, uint16_t width = FPM383_IMAGE_WIDTH, uint16_t height = FPM383_IMAGE_HEIGHT);
+    FPM383DataSink sink();              // 回调模式接收端，传给 upImage(sink)
+    uint32_t drain(FPM383RingBuffer &ring);     // 读出环形缓冲区中的数据写入文件，返回本次写入字节数
+    bool close();                       // 关闭文件；写入字节数与图像大小一致返回 true
+    uint32_t written();
+
+  private:
+    FILE *_file;
+    uint32_t _size;                     // 图像字节数
+    uint32_t _written;
+    bool _ok;
+
+    static bool write(void *context, const uint8_t *data, uint16_t length);
+};
+
+#endif // FPM383_PGM_H
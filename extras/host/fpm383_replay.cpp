@@ -0,0 +1,263 @@
+/******************************************************************************
+  fpm383_replay.cpp
+  YFROBOT FPM383 Sensor Library Linux host trace replay
+  Update Date: 04-11-2024
+  @ YFROBOT
+
+  Distributed as-is; no warranty is given.
+******************************************************************************/
+
+#include "fpm383_replay.h"
+#include <stdio.h>
+
+static bool readVarint(const std::vector<uint8_t> &log, size_t &pos, uint32_t &value)
+{
+    value = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        if (pos >= log.size()) return false;
+        uint8_t b = log[pos++];
+        value |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+static void writeVarint(std::vector<uint8_t> &log, uint32_t value)
+{
+    do {
+        uint8_t b = value & 0x7F;
+        value >>= 7;
+        log.push_back(value ? b | 0x80 : b);
+    } while (value);
+}
+
+/**
+  * @brief   解码记录
+  * @return  false：不是记录文件或记录不完整（已解码的记录保留在 events 中）
+  */
+bool fpm383DecodeTrace(const std::vector<uint8_t> &log, std::vector<FPM383TraceEvent> &events)
+{
+    events.clear();
+    if (log.size() < 4 || memcmp(&log[0], FPM383_TRACE_MAGIC, 4) != 0) return false;
+    size_t pos = 4;
+    uint64_t time = 0;
+    while (pos < log.size()) {
+        uint32_t head, size = 1;
+        if (!readVarint(log, pos, head)) return false;
+        FPM383TraceEvent e;
+        e.dir = head & 1;
+        time += head >> 1;
+        e.time = time;
+        if (e.dir == FPM383_TRACE_TX && !readVarint(log, pos, size)) return false;
+        if (log.size() - pos < size) return false;
+        e.data.assign(log.begin() + pos, log.begin() + pos + size);
+        pos += size;
+        events.push_back(e);
+    }
+    return true;
+}
+
+void fpm383EncodeTrace(const std::vector<FPM383TraceEvent> &events, std::vector<uint8_t> &log)
+{
+    log.assign(FPM383_TRACE_MAGIC, FPM383_TRACE_MAGIC + 4);
+    uint64_t time = 0;
+    for (size_t i = 0; i < events.size(); i++) {
+        const FPM383TraceEvent &e = events[i];
+        uint64_t delta = e.time > time ? e.time - time : 0;
+        time += delta;
+        if (delta > 0x7FFFFFFFUL) delta = 0x7FFFFFFFUL;
+        writeVarint(log, ((uint32_t)delta << 1) | e.dir);
+        if (e.dir == FPM383_TRACE_TX) writeVarint(log, e.data.size());
+        log.insert(log.end(), e.data.begin(), e.data.end());
+    }
+}
+
+bool fpm383LoadTrace(const char *path, std::vector<uint8_t> &log)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return false;
+    log.clear();
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) log.insert(log.end(), buf, buf + n);
+    bool ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
+
+bool fpm383SaveTrace(const char *path, const std::vector<uint8_t> &log)
+{
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) return false;
+    bool ok = fwrite(log.data(), 1, log.size(), f) == log.size();
+    return fclose(f) == 0 && ok;
+}
+
+/**
+  * @brief   变异记录中的接收数据，发送记录保持不变
+  * @param   events：记录
+  * @param   limit：只变异前 limit 条记录
+  * @param   seed：随机种子
+  * @return  变异类型 FPM383_MUTATE_*
+  */
+uint8_t fpm383MutateTrace(std::vector<FPM383TraceEvent> &events, size_t limit, uint32_t seed)
+{
+    uint32_t x = seed * 2654435761u + 1;
+    struct Rand {
+        uint32_t &x;
+        uint32_t next(uint32_t n) { x = x * 1664525u + 1013904223u; return n ? (x >> 8) % n : 0; }
+    } rnd = { x };
+
+    if (limit > events.size()) limit = events.size();
+    std::vector<size_t> rx;
+    for (size_t i = 0; i < limit; i++) {
+        if (events[i].dir == FPM383_TRACE_RX) rx.push_back(i);
+    }
+    uint8_t kind = rnd.next(FPM383_MUTATE_KINDS);
+    if (rx.empty()) return kind;
+    size_t at = rx[rnd.next(rx.size())];
+
+    switch (kind) {
+        case FPM383_MUTATE_FLIP:
+            events[at].data[0] ^= 1 << rnd.next(8);
+            break;
+        case FPM383_MUTATE_DROP: {
+            size_t n = 1 + rnd.next(12);
+            for (size_t i = at; i < limit && n > 0; ) {
+                if (events[i].dir == FPM383_TRACE_RX) {
+                    events.erase(events.begin() + i);
+                    limit--;
+                    n--;
+                } else {
+                    i++;
+                }
+            }
+            break;
+        }
+        case FPM383_MUTATE_NOISE: {
+            size_t n = 1 + rnd.next(16);
+            FPM383TraceEvent e;
+            e.time = events[at].time;
+            e.dir = FPM383_TRACE_RX;
+            for (size_t i = 0; i < n; i++) {
+                e.data.assign(1, rnd.next(4) == 0 ? 0xEF : (uint8_t)rnd.next(256));    // 噪声中混入伪包头
+                events.insert(events.begin() + at, e);
+            }
+            break;
+        }
+        case FPM383_MUTATE_TRUNCATE:
+            for (size_t i = at; i < limit; ) {
+                if (events[i].dir == FPM383_TRACE_RX) {
+                    events.erase(events.begin() + i);
+                    limit--;
+                } else {
+                    i++;
+                }
+            }
+            break;
+        case FPM383_MUTATE_DELAY: {
+            uint64_t delay = 1000 + (uint64_t)rnd.next(3000) * 1000;    // 1~3秒，超过多数指令的等待时间
+            for (size_t i = at; i < events.size(); i++) events[i].time += delay;
+            break;
+        }
+    }
+    return kind;
+}
+
+FPM383ReplayTransport::FPM383ReplayTransport(const std::vector<FPM383TraceEvent> &events)
+    : _rxRead(0), _rxDue(0), _txMatched(0), _txNext(0), _txMismatches(0)
+{
+    uint64_t last = 0;
+    for (size_t i = 0; i < events.size(); i++) {
+        if (events[i].dir == FPM383_TRACE_RX) {
+            _rxAfter.push_back(_tx.size());
+            _rxOffset.push_back(events[i].time > last ? events[i].time - last : 0);
+            _rxData.push_back(events[i].data[0]);
+        } else {
+            _tx.push_back(&events[i]);
+            last = events[i].time;
+        }
+    }
+    _base = micros();       // 与 FPM383TraceTransport 构造时相同，调用一次 micros()
+}
+
+int FPM383ReplayTransport::available()
+{
+    uint64_t now = hostClockMicros() - _base;
+    while (_rxDue < _rxData.size() && _rxAfter[_rxDue] <= _txMatched) {
+        uint64_t sent = _rxAfter[_rxDue] == 0 ? 0 : _txTime[_rxAfter[_rxDue] - 1];
+        if (sent + _rxOffset[_rxDue] > now) break;
+        _rxDue++;
+    }
+    return _rxDue - _rxRead;
+}
+
+int FPM383ReplayTransport::read()
+{
+    if (available() <= 0) return -1;
+    micros();
+    return _rxData[_rxRead++];
+}
+
+/**
+  * @brief   与下一条发送记录比较；一致时把虚拟时钟推进到记录中写入完成的时间（模拟按波特率发送的耗时）
+  */
+size_t FPM383ReplayTransport::write(const uint8_t *buffer, size_t size)
+{
+    uint64_t now = micros() - _base;
+    if (_txNext >= _tx.size()) {
+        _txMismatches++;
+        return size;
+    }
+    const FPM383TraceEvent &e = *_tx[_txNext++];
+    if (_txMismatches > 0 || e.data.size() != size || memcmp(&e.data[0], buffer, size) != 0) {
+        _txMismatches++;
+        return size;
+    }
+    if (e.time > now) {
+        hostClockAdvance(e.time - now);
+        now = e.time;
+    }
+    _txTime.push_back(now);
+    _txMatched++;
+    return size;
+}
+
+uint32_t FPM383ReplayTransport::txMismatches()
+{
+    return _txMismatches;
+}
+
+bool FPM383ReplayTransport::finished()
+{
+    return _rxRead == _rxData.size();
+}
+
+/**
+  * @brief   将记录中的全部接收字节依次送入帧解析器，不经过传输接口与超时；数据包按多包接收处理
+  * @param   fpm：解析器所属对象，不与模组通信
+  * @param   events：记录
+  */
+FPM383ParseResult FPM383Replay::parse(YFROBOTFPM383 &fpm, const std::vector<FPM383TraceEvent> &events)
+{
+    FPM383ParseResult result = { 0, 0, 0, 0 };
+    fpm.resetReceive();
+    fpm._sinkActive = true;
+    for (size_t i = 0; i < events.size(); i++) {
+        if (events[i].dir != FPM383_TRACE_RX) continue;
+        result.bytes++;
+        uint8_t r = fpm.feedByte(events[i].data[0]);
+        while (true) {
+            if (r == FPM383_RX_DONE) {
+                result.frames++;
+                result.lastFrameEnd = result.bytes;
+            }
+            if (r == FPM383_RX_ERROR) result.errors++;
+            if (fpm._rxReplay == fpm._rxReplayEnd) break;
+            r = fpm.feedByte(fpm.PS_ReceiveBuffer[fpm._rxReplay++]);   // 重新同步后保留的字节
+        }
+    }
+    fpm._sinkActive = false;
+    fpm.resetReceive();
+    return result;
+}
@@ -0,0 +1,93 @@
+/******************************************************************************
+  fpm383_replay.h
+  YFROBOT FPM383 Sensor Library Linux host trace replay
+  Update Date: 04-11-2024
+  @ YFROBOT
+
+  回放 FPM383TraceTransport 记录的串口数据（格式见 src/fpm383_trace.h）：
+  FPM383ReplayTransport 在虚拟时钟下交付接收字节：每个字节在主机发出记录中它之前的那条指令之后、
+  按记录中距该指令的时间到达，同一程序回放得到与记录时相同的结果。主机发送的内容与记录不一致后，
+  模组对之后指令的应答无从得知，只继续交付已发送指令的应答；
+  FPM383Replay::parse() 不经过传输接口，将全部接收字节直接送入帧解析器，用于测量解析吞吐量；
+  fpm383MutateTrace() 生成变异记录（位翻转、丢字节、插入噪声、截断、延迟），用于模糊测试。
+
+  Distributed as-is; no warranty is given.
+******************************************************************************/
+
+#ifndef FPM383_REPLAY_H
+#define FPM383_REPLAY_H
+
+#include "yfrobot_fpm383.h"
+#include "fpm383_trace.h"
+#include <vector>
+
+struct FPM383TraceEvent
+{
+    uint64_t time;                  // 距记录开始的微秒数
+    uint8_t dir;                    // FPM383_TRACE_RX / FPM383_TRACE_TX
+    std::vector<uint8_t> data;      // 接收记录为1字节
+};
+
+// 记录输出到内存
+class FPM383TraceBuffer : public Print
+{
+  public:
+    size_t write(uint8_t c) { data.push_back(c); return 1; }
+    size_t write(const uint8_t *buffer, size_t size) { data.insert(data.end(), buffer, buffer + size); return size; }
+    std::vector<uint8_t> data;
+};
+
+bool fpm383DecodeTrace(const std::vector<uint8_t> &log, std::vector<FPM383TraceEvent> &events);
+void fpm383EncodeTrace(const std::vector<FPM383TraceEvent> &events, std::vector<uint8_t> &log);
+bool fpm383LoadTrace(const char *path, std::vector<uint8_t> &log);
+bool fpm383SaveTrace(const char *path, const std::vector<uint8_t> &log);
+
+// 变异 events 中前 limit 条记录的接收数据，同一 seed 结果相同；返回变异类型 FPM383_MUTATE_*
+#define FPM383_MUTATE_FLIP      0   // 翻转一位
+#define FPM383_MUTATE_DROP      1   // 丢失一段字节
+#define FPM383_MUTATE_NOISE     2   // 插入随机字节
+#define FPM383_MUTATE_TRUNCATE  3   // 丢弃某条记录之后的全部接收字节直到 limit
+#define FPM383_MUTATE_DELAY     4   // 之后的全部字节推迟到达
+#define FPM383_MUTATE_KINDS     5
+uint8_t fpm383MutateTrace(std::vector<FPM383TraceEvent> &events, size_t limit, uint32_t seed);
+
+class FPM383ReplayTransport : public FPM383Transport
+{
+  public:
+    FPM383ReplayTransport(const std::vector<FPM383TraceEvent> &events);
+    int available();
+    int read();
+    size_t write(const uint8_t *buffer, size_t size);
+
+    uint32_t txMismatches();        // 发送内容与记录不一致的次数（主机行为与记录时不同）
+    bool finished();                // 记录中的接收字节已全部读出
+
+  private:
+    std::vector<uint32_t> _rxAfter;         // 接收字节之前的发送记录数
+    std::vector<uint64_t> _rxOffset;        // 距之前最后一条发送记录（或记录开始）的时间
+    std::vector<uint8_t> _rxData;
+    std::vector<const FPM383TraceEvent *> _tx;
+    std::vector<uint64_t> _txTime;          // 回放时各条指令的发送时间
+    uint64_t _base;
+    size_t _rxRead;                 // 已读出的接收字节数
+    size_t _rxDue;                  // 已到达的接收字节数
+    size_t _txMatched;              // 与记录一致的发送次数，出现不一致后不再增加
+    size_t _txNext;
+    uint32_t _txMismatches;
+};
+
+struct FPM383ParseResult
+{
+    uint32_t bytes;                 // 接收字节数
+    uint32_t frames;                // 校验正确的帧
+    uint32_t errors;                // 校验和错误或包长度非法（已重新同步）
+    uint32_t lastFrameEnd;          // 最后一个完整帧结束时已送入的字节数，等于 bytes 表示末尾的帧解析正确
+};
+
+class FPM383Replay
+{
+  public:
+    static FPM383ParseResult parse(YFROBOTFPM383 &fpm, const std::vector<FPM383TraceEvent> &events);
+};
+
+#endif // FPM383_REPLAY_H
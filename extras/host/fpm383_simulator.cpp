@@ -0,0 +1,559 @@
+/******************************************************************************
+  fpm383_simulator.cpp
+  YFROBOT FPM383 Sensor Library Linux host simulator
+  Update Date: 04-11-2024
+  @ YFROBOT
+
+  Distributed as-is; no warranty is given.
+******************************************************************************/
+
+#include "fpm383_simulator.h"
+#include "yfrobot_fpm383.h"      // FPM383_IMAGE_*
+
+static const char SIM_CHIP_SN[] = "FPM383SIM0000001";
+
+FPM383Simulator::FPM383Simulator(uint16_t capacity)
+    : _library(capacity, -1), _busyUntil(0), _baud(57600), _hostBaud(57600), _fingerTimeoutUs(4000000), _byteGapUs(0),
+      _burstSplit(0), _burstGapUs(0), _corruptReplies(0), _badCapture(0),
+      _job(0), _jobCounter(0), _activeJob(0), _jobID(-1), _jobPrevious(-1), _jobStoreUs(0), _finger(FPM383_SIM_NO_FINGER), _touchPin(-1),
+      _imageFinger(-1), _packetSize(128), _downBuffer(0), _asleep(false),
+      _securityLevel(3), _led(0), _framesReceived(0), _bytesReceived(0), _bytesSent(0)
+{
+    _charBuf[0] = _charBuf[1] = _charBuf[2] = -1;
+    for (int i = 0; i < 256; i++) {
+        _processUs[i] = 1000;
+        _commandCount[i] = 0;
+        _failCount[i] = 0;
+    }
+    _processUs[0x01] = 30000;   // 获取图像
+    _processUs[0x02] = 50000;   // 生成特征
+    _processUs[0x03] = 5000;    // 精确比对
+    _processUs[0x04] = 10000;   // 搜索指纹
+    _searchUsPerId = 0;
+    _processUs[0x0C] = 20000;   // 删除指纹
+    _processUs[0x0D] = 50000;   // 清空指纹库
+    _processUs[0x31] = 300000;  // 自动注册，每次采集
+    _processUs[0x32] = 90000;   // 自动验证：采图 + 生成特征 + 搜索
+    _processUs[0x3C] = 500;     // LED 控制
+}
+
+int FPM383Simulator::available()
+{
+    uint64_t now = hostClockMicros();
+    int n = 0;
+    for (size_t i = 0; i < _rx.size() && _rx[i].time <= now; i++) n++;
+    return n;
+}
+
+int FPM383Simulator::read()
+{
+    if (_rx.empty() || _rx.front().time > hostClockMicros()) return -1;
+    uint8_t b = _rx.front().data;
+    _rx.pop_front();
+    _bytesSent++;
+    return b;
+}
+
+size_t FPM383Simulator::write(const uint8_t *buffer, size_t size)
+{
+    _bytesReceived += size;
+    hostClockAdvance((uint64_t)size * byteTime());  // 与软件串口相同，发送阻塞至最后一个字节发出
+    uint64_t cmdEnd = hostClockMicros();
+    if (_busyUntil < cmdEnd) _busyUntil = cmdEnd;
+    if (_hostBaud != _baud) return size;    // 波特率不一致，模组收到乱码
+    _cmd.insert(_cmd.end(), buffer, buffer + size);
+
+    // 按包头、包长度切分完整指令包
+    while (true) {
+        size_t start = 0;
+        while (start + 1 < _cmd.size() && !(_cmd[start] == 0xEF && _cmd[start + 1] == 0x01)) start++;
+        _cmd.erase(_cmd.begin(), _cmd.begin() + start);
+        if (_cmd.size() < 9) break;
+        uint16_t len = ((uint16_t)_cmd[7] << 8) | _cmd[8];
+        if (len < 3) {
+            _cmd.erase(_cmd.begin());
+            continue;
+        }
+        if (_cmd.size() < 9u + len) break;
+
+        uint16_t sum = 0;
+        for (size_t i = 6; i < 9u + len - 2; i++) sum += _cmd[i];
+        uint16_t got = ((uint16_t)_cmd[9 + len - 2] << 8) | _cmd[9 + len - 1];
+        _framesReceived++;
+        if (_cmd[6] == 0x01 && sum == got) {
+            _commandCount[_cmd[9]]++;
+            handleCommand(_cmd[9], &_cmd[10], len - 3);
+        } else if ((_cmd[6] == 0x02 || _cmd[6] == 0x08) && _downBuffer) {    // 下载数据包
+            if (sum == got && len - 2u <= _packetSize) {    // 超过数据包大小的数据包视为错误
+                _downData.insert(_downData.end(), _cmd.begin() + 9, _cmd.begin() + 9 + len - 2);
+            } else {
+                _downData.clear();
+                _downData.push_back(0);     // 标记数据损坏
+            }
+            if (_cmd[6] == 0x08) {
+                _charBuf[_downBuffer] = templateFinger(_downData);
+                _downBuffer = 0;
+            }
+        } else if (_cmd[6] == 0x01) {
+            replyCode(0x01, 0);     // 收包有错
+        }
+        _cmd.erase(_cmd.begin(), _cmd.begin() + 9 + len);
+    }
+    return size;
+}
+
+void FPM383Simulator::setFinger(int finger)
+{
+    _finger = finger;
+    updateTouch();
+}
+
+void FPM383Simulator::setTouchPin(int pin)
+{
+    _touchPin = pin;
+    updateTouch();
+}
+
+void FPM383Simulator::updateTouch()
+{
+    if (_touchPin >= 0) hostPinWrite(_touchPin, !_asleep || _finger != FPM383_SIM_NO_FINGER ? HIGH : LOW);
+}
+
+void FPM383Simulator::setTemplate(uint16_t id, int finger)
+{
+    if (id < _library.size()) _library[id] = finger;
+}
+
+int FPM383Simulator::templateAt(uint16_t id) const
+{
+    return id < _library.size() ? _library[id] : -1;
+}
+
+std::vector<uint8_t> FPM383Simulator::templateData(int finger)
+{
+    std::vector<uint8_t> data(FPM383_SIM_TEMPLATE_SIZE);
+    uint32_t x = 0x9E3779B9u ^ (uint32_t)finger;
+    for (size_t i = 0; i < data.size(); i++) {
+        x = x * 1664525u + 1013904223u;
+        data[i] = x >> 24;
+    }
+    data[0] = 'F';
+    data[1] = 'P';
+    data[2] = finger >> 8;
+    data[3] = finger;
+    return data;
+}
+
+/**
+  * @brief   模拟图像：随手指变化的同心纹路
+  */
+std::vector<uint8_t> FPM383Simulator::imageData(int finger)
+{
+    std::vector<uint8_t> data(FPM383_IMAGE_SIZE);
+    int cx = FPM383_IMAGE_WIDTH / 2 + finger % 17 - 8;
+    int cy = FPM383_IMAGE_HEIGHT / 2 + finger % 13 - 6;
+    for (int y = 0; y < FPM383_IMAGE_HEIGHT; y++) {
+        for (int x = 0; x < FPM383_IMAGE_WIDTH; x++) {
+            int r2 = (x - cx) * (x - cx) + (y - cy) * (y - cy);
+            data[y * FPM383_IMAGE_WIDTH + x] = (r2 / (24 + finger % 7)) & 8 ? 0x30 : 0xD0;
+        }
+    }
+    return data;
+}
+
+/**
+  * @brief   按数据包大小分包发送，最后一包为结束包，紧接在前一个应答包之后
+  */
+void FPM383Simulator::replyData(const std::vector<uint8_t> &data)
+{
+    for (size_t off = 0; off < data.size(); off += _packetSize) {
+        size_t n = data.size() - off > _packetSize ? _packetSize : data.size() - off;
+        reply(off + n < data.size() ? 0x02 : 0x08, &data[off], n, 0);
+    }
+}
+
+int FPM383Simulator::templateFinger(const std::vector<uint8_t> &data)
+{
+    if (data.size() < 4) return -1;
+    int finger = ((int)data[2] << 8) | data[3];
+    return data == templateData(finger) ? finger : -1;
+}
+
+void FPM383Simulator::setBaudRate(uint32_t baud)
+{
+    _hostBaud = baud;
+    _cmd.clear();
+}
+
+void FPM383Simulator::setModuleBaud(uint32_t baud)
+{
+    _baud = baud;
+}
+
+void FPM383Simulator::setProcessTime(uint8_t cmd, uint32_t us)
+{
+    _processUs[cmd] = us;
+}
+
+void FPM383Simulator::setFingerTimeout(uint32_t us)
+{
+    _fingerTimeoutUs = us;
+}
+
+void FPM383Simulator::setBadCapture(uint8_t index)
+{
+    _badCapture = index;
+}
+
+void FPM383Simulator::setByteGap(uint32_t us)
+{
+    _byteGapUs = us;
+}
+
+void FPM383Simulator::setSearchTimePerId(uint32_t us)
+{
+    _searchUsPerId = us;
+}
+
+void FPM383Simulator::setBurst(uint8_t splitAt, uint32_t gapUs)
+{
+    _burstSplit = splitAt;
+    _burstGapUs = gapUs;
+}
+
+void FPM383Simulator::injectNoise(const uint8_t *data, size_t len)
+{
+    uint64_t t = _busyUntil > hostClockMicros() ? _busyUntil : hostClockMicros();
+    for (size_t i = 0; i < len; i++) {
+        t += byteTime();
+        RxByte b = { t, data[i], 0 };
+        _rx.push_back(b);
+    }
+    _busyUntil = t;
+}
+
+uint32_t FPM383Simulator::byteTime() const
+{
+    return (11 * 1000000UL + _baud - 1) / _baud;    // 8N2：1 起始位 + 8 数据位 + 2 停止位
+}
+
+/**
+  * @brief   生成应答包并按波特率排入接收队列
+  * @param   pid：包标识，0x07 应答包，0x02 数据包，0x08 结束包
+  * @param   payload：确认码及参数
+  * @param   processUs：模组处理时间
+  */
+void FPM383Simulator::reply(uint8_t pid, const uint8_t *payload, uint16_t len, uint32_t processUs)
+{
+    std::vector<uint8_t> frame;
+    uint16_t plen = len + 2;
+    uint8_t head[9] = { 0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, pid, (uint8_t)(plen >> 8), (uint8_t)plen };
+    frame.insert(frame.end(), head, head + 9);
+    frame.insert(frame.end(), payload, payload + len);
+    uint16_t sum = 0;
+    for (size_t i = 6; i < frame.size(); i++) sum += frame[i];
+    if (_corruptReplies > 0) {
+        sum ^= 0x0100;
+        _corruptReplies--;
+    }
+    frame.push_back(sum >> 8);
+    frame.push_back(sum);
+
+    uint64_t t = _busyUntil + processUs;
+    for (size_t i = 0; i < frame.size(); i++) {
+        t += byteTime();
+        if (i > 0) t += _byteGapUs;
+        if (_burstSplit && i == _burstSplit) t += _burstGapUs;
+        RxByte b = { t, _hostBaud == _baud ? frame[i] : (uint8_t)(frame[i] * 3 + 0x80), _job };    // 波特率不一致，主机收到乱码
+        _rx.push_back(b);
+    }
+    _busyUntil = t;
+}
+
+void FPM383Simulator::replyCode(uint8_t code, uint32_t processUs)
+{
+    reply(0x07, &code, 1, processUs);
+}
+
+/**
+  * @brief   处理一条校验正确的指令包
+  * @param   cmd：指令码
+  * @param   params：参数
+  * @param   len：参数长度
+  */
+void FPM383Simulator::handleCommand(uint8_t cmd, const uint8_t *params, uint16_t len)
+{
+    uint32_t t = _processUs[cmd];
+    if (cmd != 0x33 && _asleep) {       // 任意指令唤醒模组
+        _asleep = false;
+        updateTouch();
+    }
+    if (_failCount[cmd] > 0) {
+        _failCount[cmd]--;
+        replyCode(0x01, t);
+        return;
+    }
+
+    switch (cmd) {
+        case 0x01: {    // 获取图像
+            _imageFinger = _finger;
+            replyCode(_finger == FPM383_SIM_NO_FINGER ? 0x02 : 0x00, t);
+            break;
+        }
+        case 0x02: {    // 生成特征
+            uint8_t buf = len >= 1 && params[0] == 2 ? 2 : 1;
+            _charBuf[buf] = _imageFinger;
+            replyCode(_imageFinger < 0 ? 0x15 : 0x00, t);
+            break;
+        }
+        case 0x03: {    // 精确比对缓冲区1、2
+            bool same = _charBuf[1] >= 0 && _charBuf[1] == _charBuf[2];
+            uint8_t r[3] = { (uint8_t)(same ? 0x00 : 0x08), 0x00, (uint8_t)(same ? 0x64 : 0x00) };
+            reply(0x07, r, 3, t);
+            break;
+        }
+        case 0x04: {    // 搜索指纹：缓冲区号、起始页、页数
+            uint16_t start = len >= 3 ? ((uint16_t)params[1] << 8) | params[2] : 0;
+            uint16_t count = len >= 5 ? ((uint16_t)params[3] << 8) | params[4] : 0xFFFF;
+            uint8_t r[5] = { 0x09, 0x00, 0x00, 0x00, 0x00 };
+            int finger = _charBuf[len >= 1 && params[0] == 2 ? 2 : 1];
+            for (uint32_t id = start; finger >= 0 && id < _library.size() && id < (uint32_t)start + count; id++) {
+                if (_library[id] >= 0) t += _searchUsPerId;
+                if (_library[id] == finger) {
+                    r[0] = 0x00;
+                    r[1] = id >> 8;
+                    r[2] = id;
+                    r[3] = 0x00;
+                    r[4] = 0x64;
+                    break;
+                }
+            }
+            reply(0x07, r, 5, t);
+            break;
+        }
+        case 0x06:      // 储存模板：缓冲区号、ID号
+        case 0x07: {    // 读出模板：缓冲区号、ID号
+            uint8_t buf = params[0];
+            uint16_t id = ((uint16_t)params[1] << 8) | params[2];
+            if (buf < 1 || buf > 2 || id >= _library.size()) {
+                replyCode(0x0B, t);         // ID 超出范围
+            } else if (cmd == 0x06) {
+                _library[id] = _charBuf[buf];
+                replyCode(_charBuf[buf] < 0 ? 0x18 : 0x00, t);
+            } else {
+                _charBuf[buf] = _library[id];
+                replyCode(_library[id] < 0 ? 0x0C : 0x00, t);
+            }
+            break;
+        }
+        case 0x08: {    // 上传特征：缓冲区号，应答后发送数据包
+            uint8_t buf = params[0];
+            if (buf < 1 || buf > 2 || _charBuf[buf] < 0) {
+                replyCode(0x0D, t);
+                break;
+            }
+            replyCode(0x00, t);
+            replyData(templateData(_charBuf[buf]));
+            break;
+        }
+        case 0x09: {    // 下载特征：缓冲区号，应答后接收数据包
+            uint8_t buf = params[0];
+            if (buf < 1 || buf > 2) {
+                replyCode(0x0E, t);
+                break;
+            }
+            _downBuffer = buf;
+            _downData.clear();
+            replyCode(0x00, t);
+            break;
+        }
+        case 0x0A: {    // 上传图像，应答后发送数据包
+            if (_imageFinger < 0) {
+                replyCode(0x15, t);         // 图像缓冲区内没有有效图像
+                break;
+            }
+            replyCode(0x00, t);
+            replyData(imageData(_imageFinger));
+            break;
+        }
+        case 0x0C: {    // 删除指纹：起始ID、个数
+            uint16_t id = ((uint16_t)params[0] << 8) | params[1];
+            uint16_t count = ((uint16_t)params[2] << 8) | params[3];
+            if (id >= _library.size()) {
+                replyCode(0x10, t);
+                break;
+            }
+            for (uint32_t i = id; i < _library.size() && i < (uint32_t)id + count; i++) _library[i] = -1;
+            replyCode(0x00, t);
+            break;
+        }
+        case 0x0D: {    // 清空指纹库
+            for (size_t i = 0; i < _library.size(); i++) _library[i] = -1;
+            replyCode(0x00, t);
+            break;
+        }
+        case 0x0E: {    // 写系统寄存器：寄存器序号、内容
+            if (params[0] == 4 && params[1] >= 1 && params[1] <= 12) {
+                replyCode(0x00, t);
+                _baud = params[1] * 9600;   // 应答以原波特率发送后切换
+            } else if (params[0] == 5 && params[1] >= 1 && params[1] <= 5) {
+                _securityLevel = params[1];
+                replyCode(0x00, t);
+            } else if (params[0] == 6 && params[1] <= 3) {
+                _packetSize = 32 << params[1];
+                replyCode(0x00, t);
+            } else {
+                replyCode(0x1A, t);         // 寄存器序号或内容错误
+            }
+            break;
+        }
+        case 0x0F: {    // 读模组基本参数
+            uint8_t r[17] = { 0x00 };
+            r[5] = _library.size() >> 8;    // 指纹库大小
+            r[6] = _library.size();
+            r[8] = _securityLevel;          // 安全等级
+            r[9] = 0xFF; r[10] = 0xFF; r[11] = 0xFF; r[12] = 0xFF;  // 设备地址
+            for (uint16_t n = 32; n < _packetSize; n <<= 1) r[14]++;   // 数据包大小 0~3：32/64/128/256 字节
+            r[16] = _baud / 9600;           // 波特率 N*9600
+            reply(0x07, r, 17, t);
+            break;
+        }
+        case 0x1D: {    // 有效模板个数
+            uint16_t n = 0;
+            for (size_t i = 0; i < _library.size(); i++) if (_library[i] >= 0) n++;
+            uint8_t r[3] = { 0x00, (uint8_t)(n >> 8), (uint8_t)n };
+            reply(0x07, r, 3, t);
+            break;
+        }
+        case 0x1F: {    // 读索引表：索引页
+            uint8_t r[33] = { 0x00 };
+            for (size_t i = 0; i < 256; i++) {
+                size_t id = params[0] * 256 + i;
+                if (id < _library.size() && _library[id] >= 0) r[1 + i / 8] |= 1 << (i % 8);
+            }
+            reply(0x07, r, 33, t);
+            break;
+        }
+        case 0x30: {    // 取消：丢弃自动注册/自动验证尚未发出的应答，立即应答
+            uint64_t now = hostClockMicros();
+            if (_activeJob) {
+                for (size_t i = 0; i < _rx.size(); ) {
+                    if (_rx[i].job == _activeJob && _rx[i].time > now) _rx.erase(_rx.begin() + i);
+                    else i++;
+                }
+                if (_jobID >= 0 && _jobStoreUs > now) _library[_jobID] = _jobPrevious;    // 尚未存储，撤销注册
+                _busyUntil = _rx.empty() || _rx.back().time < now ? now : _rx.back().time;
+                _activeJob = 0;
+                _jobID = -1;
+            }
+            replyCode(0x00, t);
+            break;
+        }
+        case 0x31: {    // 自动注册：ID、录入次数、参数
+            uint16_t id = ((uint16_t)params[0] << 8) | params[1];
+            uint8_t times = params[2] ? params[2] : 1;
+            uint16_t flags = ((uint16_t)params[3] << 8) | params[4];
+            uint8_t r[3] = { 0x00, 0x06, 0xF2 };
+            if (id >= _library.size()) {
+                r[0] = 0x0B; r[1] = 0x00; r[2] = 0x00;      // ID 超出范围
+                reply(0x07, r, 3, 1000);
+                break;
+            } else if (_library[id] >= 0 && !(flags & 0x08)) {
+                r[0] = 0x22; r[1] = 0x00; r[2] = 0x00;      // 该ID已注册
+                reply(0x07, r, 3, 1000);
+                break;
+            }
+            _job = _activeJob = ++_jobCounter;
+            if (_finger == FPM383_SIM_NO_FINGER) {
+                r[0] = 0x26; r[1] = 0x01; r[2] = 0x01;      // 采图超时
+                reply(0x07, r, 3, _fingerTimeoutUs);
+                _job = 0;
+                break;
+            }
+            // 每次采集：获取图像(0x01) -> 生成特征(0x02) -> 手指离开(0x03)；之后合并(0x04)、检验(0x05)、存储(0x06)
+            bool status = !(flags & 0x04);
+            uint32_t idle = 0;                              // 不返回状态时累计的处理时间
+            for (uint8_t i = 1; i <= times; i++) {
+                for (uint8_t attempt = 0; attempt < 2; attempt++) {
+                    bool bad = attempt == 0 && i == _badCapture;
+                    uint8_t image[3] = { 0x00, 0x01, i };
+                    uint8_t gen[3] = { (uint8_t)(bad ? 0x07 : 0x00), 0x02, i };    // 0x07 特征点太少
+                    if (status) {
+                        reply(0x07, image, 3, idle + t * 2 / 5);
+                        reply(0x07, gen, 3, t / 5);
+                        idle = 0;
+                    } else {
+                        idle += t * 3 / 5;
+                    }
+                    if (!bad) break;
+                }
+                uint8_t leave[3] = { 0x00, 0x03, i };
+                if (status && i < times) reply(0x07, leave, 3, t * 2 / 5);
+                else idle += t * 2 / 5;
+            }
+            static const uint8_t stages[2][3] = { { 0x00, 0x04, 0xF0 }, { 0x00, 0x05, 0xF1 } };
+            if (status) {
+                reply(0x07, stages[0], 3, idle + 20000);
+                reply(0x07, stages[1], 3, 20000);
+                idle = 0;
+            } else {
+                idle += 40000;
+            }
+            _jobID = id;
+            _jobPrevious = _library[id];
+            _jobStoreUs = _busyUntil + idle + 20000;
+            _library[id] = _finger;
+            reply(0x07, r, 3, idle + 20000);
+            _job = 0;
+            break;
+        }
+        case 0x32: {    // 自动验证：分数等级、ID号、参数
+            uint16_t id = ((uint16_t)params[1] << 8) | params[2];
+            uint16_t flags = ((uint16_t)params[3] << 8) | params[4];
+            uint8_t r[6] = { 0x09, 0x05, 0x00, 0x00, 0x00, 0x00 };
+            _job = _activeJob = ++_jobCounter;
+            _jobID = -1;
+            if (_finger == FPM383_SIM_NO_FINGER) {
+                r[0] = 0x26; r[1] = 0x01;                   // 采图超时
+                reply(0x07, r, 6, _fingerTimeoutUs);
+                _job = 0;
+                break;
+            }
+            if (!(flags & 0x04)) {                          // 返回关键步骤状态：获取图像成功
+                uint8_t s[6] = { 0x00, 0x01, 0x00, 0x00, 0x00, 0x00 };
+                reply(0x07, s, 6, _processUs[0x01]);
+                t -= _processUs[0x01];
+            }
+            _imageFinger = _charBuf[1] = _finger;
+            for (uint32_t i = 0; i < _library.size(); i++) {
+                if (_library[i] == _finger && (id == 0xFFFF || id == i)) {
+                    r[0] = 0x00; r[2] = i >> 8; r[3] = i; r[5] = 0x64;
+                    break;
+                }
+            }
+            reply(0x07, r, 6, t);
+            _job = 0;
+            break;
+        }
+        case 0x33: {    // 休眠
+            _asleep = true;
+            updateTouch();
+            replyCode(0x00, t);
+            break;
+        }
+        case 0x34: {    // 获取芯片序列号
+            uint8_t r[33] = { 0x00 };
+            memcpy(&r[1], SIM_CHIP_SN, sizeof(SIM_CHIP_SN) - 1);
+            reply(0x07, r, 33, t);
+            break;
+        }
+        case 0x3C: {    // LED 控制：功能码、起始颜色、结束颜色、循环次数
+            if (len >= 4) _led = params[0] | (params[1] << 8) | (params[2] << 16) | ((uint32_t)params[3] << 24);
+            replyCode(0x00, t);
+            break;
+        }
+        default:
+            replyCode(0x01, t);
+            break;
+    }
+}
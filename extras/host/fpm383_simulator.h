@@ -0,0 +1,121 @@
+/******************************************************************************
+  fpm383_simulator.h
+  YFROBOT FPM383 Sensor Library Linux host simulator
+  Update Date: 04-11-2024
+  @ YFROBOT
+
+  软件模拟的 FPM383 模组，实现 FPM383Transport 接口，按指令集应答。
+  字节到达时间由虚拟时钟、波特率、指令处理时间共同决定，可用于基准测试。
+
+  Distributed as-is; no warranty is given.
+******************************************************************************/
+
+#ifndef FPM383_SIMULATOR_H
+#define FPM383_SIMULATOR_H
+
+#include "fpm383_transport.h"
+#include <deque>
+#include <vector>
+
+#define FPM383_SIM_NO_FINGER    -1      // setFinger() 参数：无手指
+#define FPM383_SIM_TEMPLATE_SIZE 1024   // 模拟模板大小（字节）
+
+class FPM383Simulator : public FPM383Transport
+{
+  public:
+    FPM383Simulator(uint16_t capacity = 50);
+
+    // FPM383Transport
+    int available();
+    int read();
+    size_t write(const uint8_t *buffer, size_t size);
+    void setBaudRate(uint32_t baud);                    // 主机端波特率，与模组不一致时双方收到的都是乱码
+
+    // 手指模型：finger 为手指编号（>=0），FPM383_SIM_NO_FINGER 表示无手指
+    void setFinger(int finger);
+    // TOUCHOUT 输出引脚：唤醒时高电平；休眠后无手指为低电平，手指按下变为高电平
+    void setTouchPin(int pin);
+    int finger() const { return _finger; }
+    // 直接在指纹库中放置/查询模板（模拟已注册状态）
+    void setTemplate(uint16_t id, int finger);
+    int templateAt(uint16_t id) const;
+    // 模板内容由手指编号确定：上传得到的数据下载回模组后可还原为同一手指
+    static std::vector<uint8_t> templateData(int finger);
+    static int templateFinger(const std::vector<uint8_t> &data);
+    static std::vector<uint8_t> imageData(int finger);  // 上传图像 0x0A 的内容：FPM383_IMAGE_SIZE 字节灰度
+    int charBuffer(uint8_t bufferID) const { return bufferID < 3 ? _charBuf[bufferID] : -1; }
+
+    // 时序配置
+    void setModuleBaud(uint32_t baud);                  // 模组串口波特率
+    uint32_t moduleBaud() const { return _baud; }
+    void setPacketSize(uint16_t size) { _packetSize = size; }   // 数据包载荷大小 32/64/128/256，超出的下载数据包视为错误
+    uint16_t packetSize() const { return _packetSize; }
+    void setProcessTime(uint8_t cmd, uint32_t us);      // 指令处理时间（收完指令到开始应答）
+    void setSearchTimePerId(uint32_t us);               // 搜索指纹时每比对一个已注册模板增加的处理时间
+    void setFingerTimeout(uint32_t us);                 // 自动注册/自动验证等待手指超时时间
+    void setBadCapture(uint8_t index);                  // 自动注册第 index 次采集特征点太少，需重新采集；0 表示无
+    void setByteGap(uint32_t us);                       // 应答字节之间的额外间隔
+    void setBurst(uint8_t splitAt, uint32_t gapUs);     // 应答包在第 splitAt 字节后停顿 gapUs，模拟分段到达
+    void injectNoise(const uint8_t *data, size_t len);  // 插入无效字节，测试重新同步
+    void corruptReplies(uint32_t count) { _corruptReplies = count; }    // 之后 count 个应答包校验和错误
+    void failCommand(uint8_t cmd, uint32_t count) { _failCount[cmd] = count; }  // 之后 count 次该指令不执行，应答确认码0x01
+
+    // 统计
+    uint32_t framesReceived() const { return _framesReceived; }
+    uint32_t bytesReceived() const { return _bytesReceived; }
+    uint32_t bytesSent() const { return _bytesSent; }
+    uint32_t commandCount(uint8_t cmd) const { return _commandCount[cmd]; }
+    bool asleep() const { return _asleep; }
+    uint32_t led() const { return _led; }               // 最近一次 LED 指令参数：功能码 | 起始颜色<<8 | 结束颜色<<16 | 循环次数<<24
+
+  protected:
+    virtual void handleCommand(uint8_t cmd, const uint8_t *params, uint16_t len);
+    void reply(uint8_t pid, const uint8_t *payload, uint16_t len, uint32_t processUs);
+    void replyCode(uint8_t code, uint32_t processUs);
+    void replyData(const std::vector<uint8_t> &data);
+    uint32_t byteTime() const;
+    void updateTouch();
+
+    struct RxByte {
+        uint64_t time;      // 到达时间
+        uint8_t data;
+        uint32_t job;       // 所属自动注册/自动验证任务，0 表示普通应答
+    };
+    std::deque<RxByte> _rx;                         // 待主机读取的字节
+    std::vector<uint8_t> _cmd;                      // 主机发来的未处理字节
+    std::vector<int> _library;                      // 指纹库：ID -> 手指编号，-1 为空
+    uint64_t _busyUntil;                            // 模组空闲时间
+    uint32_t _baud;                                 // 模组波特率
+    uint32_t _hostBaud;                             // 主机波特率
+    uint32_t _processUs[256];
+    uint32_t _failCount[256];
+    uint32_t _searchUsPerId;
+    uint32_t _fingerTimeoutUs;
+    uint32_t _byteGapUs;
+    uint8_t _burstSplit;
+    uint32_t _burstGapUs;
+    uint32_t _corruptReplies;
+    uint8_t _badCapture;
+    uint32_t _job;                                  // 当前生成的应答所属任务
+    uint32_t _jobCounter;
+    uint32_t _activeJob;                            // 可被取消指令中止的任务
+    int _jobID;                                     // 自动注册任务的ID，-1 无
+    int _jobPrevious;                               // 自动注册前该ID中的手指
+    uint64_t _jobStoreUs;                           // 自动注册存储模板的时间
+    int _finger;
+    int _touchPin;
+    int _imageFinger;                               // 图像缓冲区中的手指，-1 无效
+    int _charBuf[3];                                // 特征缓冲区1、2中的手指，-1 无效
+    uint16_t _packetSize;                           // 数据包载荷大小
+    uint8_t _downBuffer;                            // 正在下载的特征缓冲区号，0 表示未下载
+    std::vector<uint8_t> _downData;                 // 已收到的下载数据
+    bool _asleep;
+    uint8_t _securityLevel;
+    uint32_t _led;
+    uint32_t _framesReceived;
+    uint32_t _bytesReceived;
+    uint32_t _bytesSent;
+    uint32_t _commandCount[256];
+};
+
+#endif // FPM383_SIMULATOR_H
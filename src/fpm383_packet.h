@@ -0,0 +1,58 @@
+/******************************************************************************
+  fpm383_packet.h
+  YFROBOT FPM383 Sensor Library Packet Builder
+  Update Date: 04-11-2024
+  @ YFROBOT
+
+  Distributed as-is; no warranty is given.
+******************************************************************************/
+
+#ifndef FPM383_PACKET_H
+#define FPM383_PACKET_H
+
+#include "Arduino.h"
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#elif defined(ESP32)
+#include <pgmspace.h>
+#endif
+
+// 包格式：包头0xEF01(2) 设备地址(4) 包标识(1) 包长度(2) 指令码/确认码+参数(包长度-2) 校验和(2)
+// 校验和为包标识至最后一个参数的累加和，包长度包含校验和
+#define FPM383_HEADER_SIZE      9   // 包头 + 地址 + 包标识 + 包长度
+
+// 包标识
+#define FPM383_PID_COMMAND      0x01    // 命令包
+#define FPM383_PID_DATA         0x02    // 数据包，且有后续包
+#define FPM383_PID_ACK          0x07    // 应答包
+#define FPM383_PID_END          0x08    // 最后一个数据包，即结束包
+
+// 编译期累加参数，用于计算校验和
+template <uint8_t... P> struct FPM383Sum;
+template <> struct FPM383Sum<> { static const uint16_t value = 0; };
+template <uint8_t H, uint8_t... T> struct FPM383Sum<H, T...>
+{
+    static const uint16_t value = (uint16_t)(H + FPM383Sum<T...>::value);
+};
+
+// 编译期生成的命令包：由指令码和参数自动计算包长度、校验和，完整的包存放于 flash
+// 例：FPM383Packet<0x01>::data 即获取图像指令 EF 01 FF FF FF FF 01 00 03 01 00 05
+template <uint8_t Cmd, uint8_t... Params>
+struct FPM383Packet
+{
+    static const uint16_t LENGTH = sizeof...(Params) + 3;      // 指令码 + 参数 + 校验和
+    static const uint8_t SIZE = FPM383_HEADER_SIZE + LENGTH;
+    static const uint16_t CHECKSUM = (uint16_t)(FPM383_PID_COMMAND + (LENGTH >> 8) + (LENGTH & 0xFF) + Cmd + FPM383Sum<Params...>::value);
+    static const uint8_t data[SIZE];
+};
+
+template <uint8_t Cmd, uint8_t... Params>
+const uint8_t FPM383Packet<Cmd, Params...>::data[FPM383Packet<Cmd, Params...>::SIZE] PROGMEM = {
+    0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, FPM383_PID_COMMAND,
+    (uint8_t)(LENGTH >> 8), (uint8_t)LENGTH,
+    Cmd, Params...,
+    (uint8_t)(CHECKSUM >> 8), (uint8_t)CHECKSUM
+};
+
+#endif // FPM383_PACKET_H
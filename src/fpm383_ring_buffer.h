@@ -0,0 +1,114 @@
+/******************************************************************************
+  fpm383_ring_buffer.h
+  YFROBOT FPM383 Sensor Library Source File
+  Update Date: 04-11-2024
+  @ YFROBOT
+
+  单生产者单消费者环形缓冲区：多包上传（图像、模板）时库从串口读出的字节直接写入，
+  另一个任务（ESP32）、线程（Linux）或中断同时读出并写入 SD 卡、网络等，
+  缓冲区远小于整幅图像时也能完成上传。缓冲区已满时库暂停读取串口，直到读取方腾出空间或数据包超时。
+
+  Distributed as-is; no warranty is given.
+******************************************************************************/
+
+#ifndef FPM383_RING_BUFFER_H
+#define FPM383_RING_BUFFER_H
+
+#include "Arduino.h"
+
+#if defined(ESP32) || defined(FPM383_HOST)
+#include <atomic>
+typedef std::atomic<uint32_t> FPM383RingIndex;  // 读写方在不同核/线程
+#elif defined(__AVR__)
+#include <util/atomic.h>
+typedef volatile uint32_t FPM383RingIndex;      // 8 位 AVR 读写 32 位值需多条指令，经 load()/store() 关中断访问，中断读写时不会读到一半
+#define FPM383_RING_ATOMIC_BLOCK
+#else
+typedef volatile uint32_t FPM383RingIndex;      // 32 位 MCU 对齐的 32 位读写为单条指令
+#endif
+
+class FPM383RingBuffer
+{
+  public:
+    FPM383RingBuffer(uint8_t *buffer, uint32_t capacity)
+        : _buffer(buffer), _capacity(capacity), _head(0), _tail(0) {}
+
+    // 可读字节数
+    uint32_t available()
+    {
+        return load(_head) - load(_tail);
+    }
+
+    // 可写字节数
+    uint32_t space()
+    {
+        uint32_t tail = load(_tail);
+        return _capacity - (load(_head) - tail);
+    }
+
+    // 写入一个字节，仅生产者（库）调用；已满返回 false
+    bool write(uint8_t data)
+    {
+        uint32_t head = load(_head);
+        if (head - load(_tail) >= _capacity) return false;
+        _buffer[head % _capacity] = data;
+        store(_head, head + 1);
+        return true;
+    }
+
+    // 读一个字节，仅消费者调用；无数据返回-1
+    int read()
+    {
+        uint32_t tail = load(_tail);
+        if (load(_head) == tail) return -1;
+        uint8_t data = _buffer[tail % _capacity];
+        store(_tail, tail + 1);
+        return data;
+    }
+
+    // 读出最多 size 字节，仅消费者调用；返回实际读出字节数
+    uint32_t read(uint8_t *data, uint32_t size)
+    {
+        uint32_t tail = load(_tail);
+        uint32_t n = load(_head) - tail;
+        if (n > size) n = size;
+        for (uint32_t i = 0; i < n; i++) data[i] = _buffer[(tail + i) % _capacity];
+        store(_tail, tail + n);
+        return n;
+    }
+
+    // 清空，须在没有读写时调用
+    void clear()
+    {
+        store(_head, 0);
+        store(_tail, 0);
+    }
+
+  private:
+    static uint32_t load(FPM383RingIndex &index)
+    {
+#ifdef FPM383_RING_ATOMIC_BLOCK
+        uint32_t value;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { value = index; }
+        return value;
+#else
+        return index;
+#endif
+    }
+
+    static void store(FPM383RingIndex &index, uint32_t value)
+    {
+#ifdef FPM383_RING_ATOMIC_BLOCK
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { index = value; }
+#else
+        index = value;
+#endif
+    }
+
+    uint8_t *_buffer;
+    uint32_t _capacity;
+    FPM383RingIndex _head;      // 已写入字节总数
+    FPM383RingIndex _tail;      // 已读出字节总数
+};
+
+#endif // FPM383_RING_BUFFER_H
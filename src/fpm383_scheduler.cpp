@@ -0,0 +1,124 @@
+/******************************************************************************
+  fpm383_scheduler.cpp
+  YFROBOT FPM383 Sensor Library Source File
+  Update Date: 04-11-2024
+  @ YFROBOT
+
+  Distributed as-is; no warranty is given.
+******************************************************************************/
+
+#include "fpm383_scheduler.h"
+
+FPM383Scheduler::FPM383Scheduler()
+    : _count(0), _next(0), _op(FPM383_OP_IDENTIFY), _noFingerLED(false), _interval(500), _running(false)
+{
+}
+
+/**
+  * @brief   添加模组，模组需已初始化（begin() 或 getChipSN()）
+  * @param   fpm：模组
+  * @return  false：已达到 FPM383_SCHED_MAX
+  */
+bool FPM383Scheduler::add(YFROBOTFPM383 &fpm)
+{
+    if (_count >= FPM383_SCHED_MAX) return false;
+    _sensors[_count] = &fpm;
+    _lastStart[_count] = 0;
+    _count++;
+    return true;
+}
+
+uint8_t FPM383Scheduler::count()
+{
+    return _count;
+}
+
+YFROBOTFPM383 *FPM383Scheduler::sensor(uint8_t index)
+{
+    return index < _count ? _sensors[index] : NULL;
+}
+
+/**
+  * @brief   查找模组序号，可在完成回调中区分是哪个模组
+  * @return  序号，不在调度器中返回-1
+  */
+int FPM383Scheduler::indexOf(YFROBOTFPM383 *fpm)
+{
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_sensors[i] == fpm) return i;
+    }
+    return -1;
+}
+
+/**
+  * @brief   在所有模组上开始连续识别
+  * @param   op：FPM383_OP_IDENTIFY 或 FPM383_OP_AUTO_IDENTIFY
+  * @param   NoFingerLED：无手指时是否闪烁红绿色灯一次
+  * @param   interval：同一模组两次识别开始的最小间隔（ms）
+  * @return  false：op 不支持
+  */
+bool FPM383Scheduler::start(uint8_t op, bool NoFingerLED, uint16_t interval)
+{
+    if (op != FPM383_OP_IDENTIFY && op != FPM383_OP_AUTO_IDENTIFY) return false;
+    _op = op;
+    _noFingerLED = NoFingerLED;
+    _interval = interval;
+    _running = true;
+    return true;
+}
+
+/**
+  * @brief   停止开始新的识别，进行中的操作仍需 poll() 推进至完成
+  */
+void FPM383Scheduler::stop()
+{
+    _running = false;
+}
+
+bool FPM383Scheduler::running()
+{
+    return _running;
+}
+
+/**
+  * @brief   设置所有模组的完成回调，回调的 fpm 参数指明是哪个模组
+  */
+void FPM383Scheduler::onComplete(FPM383Callback callback)
+{
+    for (uint8_t i = 0; i < _count; i++) _sensors[i]->onComplete(callback);
+}
+
+/**
+  * @brief   是否有使用软串口的模组正在收发
+  */
+bool FPM383Scheduler::exclusiveBusy()
+{
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_sensors[i]->busy() && _sensors[i]->_ss->exclusive()) return true;
+    }
+    return false;
+}
+
+/**
+  * @brief   轮流推进每个模组的异步操作，空闲的模组按间隔开始新的识别；不会阻塞
+  * @param   None
+  * @return  正在进行操作的模组数量
+  */
+uint8_t FPM383Scheduler::poll()
+{
+    uint8_t busy = 0;
+    for (uint8_t n = 0; n < _count; n++) {
+        uint8_t i = (_next + n) % _count;
+        YFROBOTFPM383 *fpm = _sensors[i];
+        fpm->poll();
+        if (!fpm->busy() && _running && millis() - _lastStart[i] >= _interval
+            && !(fpm->_ss->exclusive() && exclusiveBusy())) {
+            bool started = _op == FPM383_OP_AUTO_IDENTIFY ? fpm->beginAutoIdentify(_noFingerLED)
+                                                         : fpm->beginIdentify(_noFingerLED);
+            if (started) _lastStart[i] = millis();
+        }
+        if (fpm->busy()) busy++;
+    }
+    if (_count > 0) _next = (_next + 1) % _count;
+    return busy;
+}
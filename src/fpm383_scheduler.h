@@ -0,0 +1,55 @@
+/******************************************************************************
+  fpm383_scheduler.h
+  YFROBOT FPM383 Sensor Library Source File
+  Update Date: 04-11-2024
+  @ YFROBOT
+
+  多模组轮询调度：多个模组（如入口、出口）各自进行异步操作，poll() 轮流推进，
+  各模组的串口收发交错进行，总识别吞吐量随模组数量增加。
+  使用软串口（AVR）的模组同一时刻只能有一个在收发，调度器自动串行化这些模组。
+
+  Distributed as-is; no warranty is given.
+******************************************************************************/
+
+#ifndef FPM383_SCHEDULER_H
+#define FPM383_SCHEDULER_H
+
+#include "yfrobot_fpm383.h"
+
+#ifndef FPM383_SCHED_MAX
+#define FPM383_SCHED_MAX        8       // 最多调度的模组数量
+#endif
+
+class FPM383Scheduler
+{
+  public:
+    FPM383Scheduler();
+
+    bool add(YFROBOTFPM383 &fpm);
+    uint8_t count();
+    YFROBOTFPM383 *sensor(uint8_t index);
+    int indexOf(YFROBOTFPM383 *fpm);
+
+    // 连续识别：模组空闲且距上次开始超过 interval 毫秒时重新开始识别
+    // op：FPM383_OP_IDENTIFY（分步式）或 FPM383_OP_AUTO_IDENTIFY（一站式，模组等待手指）
+    bool start(uint8_t op, bool NoFingerLED, uint16_t interval = 500);
+    void stop();
+    bool running();
+
+    uint8_t poll();
+    void onComplete(FPM383Callback callback);
+
+  private:
+    YFROBOTFPM383 *_sensors[FPM383_SCHED_MAX];
+    unsigned long _lastStart[FPM383_SCHED_MAX];
+    uint8_t _count;
+    uint8_t _next;              // 本轮首先推进的模组，每轮后移一个，保证公平
+    uint8_t _op;
+    bool _noFingerLED;
+    uint16_t _interval;
+    bool _running;
+
+    bool exclusiveBusy();
+};
+
+#endif // FPM383_SCHEDULER_H
@@ -0,0 +1,402 @@
+/******************************************************************************
+  fpm383_template_store.cpp
+  YFROBOT FPM383 Sensor Library Source File
+  Update Date: 04-11-2024
+  @ YFROBOT
+
+  Distributed as-is; no warranty is given.
+******************************************************************************/
+
+#include "fpm383_template_store.h"
+
+#if !defined(__AVR__)
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/**
+  * @brief   主机端模板库构造函数
+  * @param   fpm：模组对象，需已 begin()
+  * @param   storage：模板存储
+  * @param   firstSlot：常驻区起始ID
+  * @param   slots：常驻区大小，最大 FPM383_MAX_IDS，常驻区内原有模板会在 begin() 时删除
+  * @param   policy：换出策略 FPM383_STORE_LRU / FPM383_STORE_LFU
+  */
+FPM383TemplateStore::FPM383TemplateStore(YFROBOTFPM383 &fpm, FPM383TemplateStorage &storage,
+                                         uint16_t firstSlot, uint16_t slots, uint8_t policy)
+    : _fpm(fpm), _storage(storage), _first(firstSlot), _slots(slots), _policy(policy),
+      _clock(0), _score(0), _coldLimit(FPM383_STORE_COLD_MAX), _coldNext(0), _coldAt(0)
+{
+    if (_first >= FPM383_MAX_IDS) _first = FPM383_MAX_IDS;
+    if (_slots > FPM383_MAX_IDS - _first) _slots = FPM383_MAX_IDS - _first;
+    memset(_users, 0, sizeof(_users));
+    for (uint16_t i = 0; i < FPM383_MAX_IDS; i++) _slotUser[i] = FPM383_NO_ID;
+    resetStats();
+}
+
+/**
+  * @brief   枚举主机存储中的用户，并清空模组常驻区；常驻区超出模组指纹库容量的部分不使用
+  * @param   None
+  * @return  true：成功
+  */
+bool FPM383TemplateStore::begin()
+{
+    if (_first > _fpm.capacity()) _first = _fpm.capacity();
+    if (_slots > _fpm.capacity() - _first) _slots = _fpm.capacity() - _first;
+    memset(_users, 0, sizeof(_users));
+    for (uint16_t i = 0; i < _slots; i++) {
+        _slotUser[i] = FPM383_NO_ID;
+        _lastUse[i] = 0;
+        _useCount[i] = 0;
+    }
+    _clock = 0;
+    _coldNext = 0;
+    if (!_storage.list(listUser, this)) return false;
+    if (!_fpm.loadIndex()) return false;
+    for (uint16_t i = 0; i < _slots; i++) {     // 常驻区有残留模板时一条指令清空整个常驻区
+        if (_fpm.isEnrolled(_first + i)) return _fpm.deleteRange(_first, _slots) == 0x00;
+    }
+    return true;
+}
+
+bool FPM383TemplateStore::listUser(void *context, uint16_t user)
+{
+    ((FPM383TemplateStore *)context)->markUser(user, true);
+    return true;
+}
+
+bool FPM383TemplateStore::hasUser(uint16_t user)
+{
+    return user < FPM383_STORE_MAX_USERS && (_users[user >> 3] & (1 << (user & 7)));
+}
+
+void FPM383TemplateStore::markUser(uint16_t user, bool present)
+{
+    if (user >= FPM383_STORE_MAX_USERS) return;
+    if (present) _users[user >> 3] |= 1 << (user & 7);
+    else _users[user >> 3] &= ~(1 << (user & 7));
+}
+
+/**
+  * @brief   查找用户所在的常驻区位置
+  * @return  常驻区下标，不在常驻区返回 FPM383_NO_ID
+  */
+uint16_t FPM383TemplateStore::slotOf(uint16_t user)
+{
+    for (uint16_t i = 0; i < _slots; i++) {
+        if (_slotUser[i] == user) return i;
+    }
+    return FPM383_NO_ID;
+}
+
+/**
+  * @brief   取得一个空闲常驻区位置，常驻区已满时按策略换出一个模板
+  * @return  常驻区下标，常驻区大小为0或删除失败返回 FPM383_NO_ID
+  */
+uint16_t FPM383TemplateStore::acquireSlot()
+{
+    uint16_t victim = FPM383_NO_ID;
+    for (uint16_t i = 0; i < _slots; i++) {
+        if (_slotUser[i] == FPM383_NO_ID) return i;
+        if (victim == FPM383_NO_ID) {
+            victim = i;
+        } else if (_policy == FPM383_STORE_LFU && _useCount[i] != _useCount[victim]) {
+            if (_useCount[i] < _useCount[victim]) victim = i;
+        } else if (_lastUse[i] < _lastUse[victim]) {
+            victim = i;
+        }
+    }
+    if (victim == FPM383_NO_ID || _fpm.deleteID(_first + victim) != 0x00) return FPM383_NO_ID;
+    _slotUser[victim] = FPM383_NO_ID;
+    _stats.evictions++;
+    return victim;
+}
+
+void FPM383TemplateStore::touch(uint16_t slot)
+{
+    _lastUse[slot] = ++_clock;
+    if (++_useCount[slot] == 0xFFFF) {     // 计数饱和时整体减半，保留相对频率
+        for (uint16_t i = 0; i < _slots; i++) _useCount[i] >>= 1;
+    }
+}
+
+/**
+  * @brief   从主机存储读出用户模板并下载到模组特征缓冲区2
+  */
+bool FPM383TemplateStore::downloadUser(uint16_t user)
+{
+    uint32_t length = 0;
+    if (!_storage.load(user, _template, sizeof(_template), &length)) return false;
+    FPM383DataSource source = { _template, length, NULL, NULL };
+    _stats.downloads++;
+    return _fpm.downChar(2, source) == 0x00;
+}
+
+/**
+  * @brief   注册新用户：在常驻区注册指纹，上传模板保存到主机存储，已有的同名用户被覆盖
+  * @param   user：用户ID，取值 0 ~ FPM383_STORE_MAX_USERS-1
+  * @param   entriesCount：录入次数
+  * @return  与 YFROBOTFPM383::enroll() 相同；上传或保存失败返回0xFF
+  */
+uint8_t FPM383TemplateStore::enroll(uint16_t user, uint8_t entriesCount)
+{
+    if (user >= FPM383_STORE_MAX_USERS) return 0xFF;
+    uint16_t slot = slotOf(user);
+    if (slot != FPM383_NO_ID) {
+        if (_fpm.deleteID(_first + slot) != 0x00) return 0xFF;
+        _slotUser[slot] = FPM383_NO_ID;
+    } else {
+        slot = acquireSlot();
+        if (slot == FPM383_NO_ID) return 0xFF;
+    }
+    uint16_t id = _first + slot;
+    uint8_t code = _fpm.enroll(id, entriesCount);
+    if (code != 0x00) return code;
+
+    uint32_t length = 0;
+    if (_fpm.uploadTemplate(id, _template, sizeof(_template), &length) != 0x00
+        || !_storage.save(user, _template, length)) {
+        _fpm.deleteID(id);
+        return 0xFF;
+    }
+    markUser(user, true);
+    _slotUser[slot] = user;
+    _useCount[slot] = 0;
+    touch(slot);
+    return 0x00;
+}
+
+/**
+  * @brief   导入模板（如从其他设备备份），只写入主机存储，首次识别时换入常驻区
+  * @param   user：用户ID
+  * @param   buffer：模板数据
+  * @param   length：模板字节数
+  * @return  true：成功
+  */
+bool FPM383TemplateStore::add(uint16_t user, const uint8_t *buffer, uint32_t length)
+{
+    if (user >= FPM383_STORE_MAX_USERS || !_storage.save(user, buffer, length)) return false;
+    markUser(user, true);
+    uint16_t slot = slotOf(user);
+    if (slot != FPM383_NO_ID) {     // 常驻区中是旧模板
+        _fpm.deleteID(_first + slot);
+        _slotUser[slot] = FPM383_NO_ID;
+    }
+    return true;
+}
+
+/**
+  * @brief   删除用户，同时从主机存储和常驻区删除
+  * @param   user：用户ID
+  * @return  true：成功
+  */
+bool FPM383TemplateStore::remove(uint16_t user)
+{
+    uint16_t slot = slotOf(user);
+    if (slot != FPM383_NO_ID) {
+        if (_fpm.deleteID(_first + slot) != 0x00) return false;
+        _slotUser[slot] = FPM383_NO_ID;
+    }
+    markUser(user, false);
+    return _storage.remove(user);
+}
+
+bool FPM383TemplateStore::contains(uint16_t user)
+{
+    return hasUser(user);
+}
+
+uint16_t FPM383TemplateStore::userCount()
+{
+    uint16_t n = 0;
+    for (uint16_t i = 0; i < sizeof(_users); i++) {
+        for (uint8_t b = _users[i]; b; b &= b - 1) n++;
+    }
+    return n;
+}
+
+/**
+  * @brief   识别指纹：先在常驻区 1:N 搜索，未命中时逐个下载非常驻模板 1:1 比对，
+  *          匹配的模板换入常驻区（必要时换出一个模板）。每个非常驻模板一次下载及比对，
+  *          本次最多比对 setColdLimit() 个，达到上限返回 FPM383_STORE_PARTIAL，手指未移开时再次调用从下一个用户继续；
+  *          期间无手指或间隔超过 FPM383_STORE_RESUME_GAP，视为新的手指，从头比对
+  * @param   searchCold：常驻区未命中时是否比对非常驻模板，false 时只搜索常驻区
+  * @return  用户ID；全部非常驻模板都不匹配返回 FPM383_STORE_UNKNOWN；达到比对上限返回 FPM383_STORE_PARTIAL；
+  *          无手指或失败返回 FPM383_STORE_NO_FINGER
+  */
+uint16_t FPM383TemplateStore::identify(bool searchCold)
+{
+    _score = 0;
+    if (_coldNext != 0 && millis() - _coldAt > FPM383_STORE_RESUME_GAP) _coldNext = 0;     // 可能已换了手指
+    if (_fpm.getImage() != 0x00 || _fpm.getChar() != 0x00) {
+        _coldNext = 0;                                              // 手指已移开，之后是新的查找
+        return FPM383_STORE_NO_FINGER;
+    }
+
+    uint16_t id = 0, score = 0;
+    uint8_t code = _fpm.searchMB(_first, _slots, &id, &score);     // 只搜索常驻区，不会命中其他应用的模板
+    if (code != 0x00 && code != 0x09) return FPM383_STORE_NO_FINGER;
+    bool resumed = _coldNext != 0;                                  // 接着上次 PARTIAL 继续，属于同一次查找
+    if (!resumed) _stats.lookups++;
+    if (code == 0x00 && id >= _first && id - _first < _slots && _slotUser[id - _first] != FPM383_NO_ID) {
+        if (resumed) _stats.lookups++;                              // 换了手指，命中常驻区算作新的查找
+        _stats.hits++;
+        _coldNext = 0;
+        touch(id - _first);
+        _score = score;
+        return _slotUser[id - _first];
+    }
+
+    uint16_t compared = 0;
+    for (uint16_t user = _coldNext; searchCold && user < FPM383_STORE_MAX_USERS; user++) {
+        if (!hasUser(user) || slotOf(user) != FPM383_NO_ID) continue;
+        if (_coldLimit != 0 && compared == _coldLimit) {    // 达到上限，下次从该用户继续
+            _coldNext = user;
+            _coldAt = millis();
+            _stats.partials++;
+            return FPM383_STORE_PARTIAL;
+        }
+        compared++;
+        if (!downloadUser(user) || _fpm.match(&score) != 0x00) continue;
+        _coldNext = 0;
+        _stats.coldHits++;
+        _score = score;
+        uint16_t slot = acquireSlot();
+        if (slot != FPM383_NO_ID && _fpm.storeChar(2, _first + slot) == 0x00) {
+            _slotUser[slot] = user;
+            _useCount[slot] = 0;
+            touch(slot);
+            _stats.pageIns++;
+        }
+        return user;
+    }
+    _coldNext = 0;
+    _stats.misses++;
+    return FPM383_STORE_UNKNOWN;
+}
+
+/**
+  * @brief   设置每次 identify() 最多比对的非常驻模板数，限制常驻区未命中时的识别时间。
+  *          非常驻模板逐个下载（PS_DownChar）并 1:1 比对（PS_Match），57600 波特率下每个约 0.23 s：
+  *          默认16个时单次调用最长约 3.8 s，但未知手指仍须比对全部非常驻模板，
+  *          200 个用户需调用 13 次共约 47 s。用户较多时应增大常驻区
+  * @param   limit：个数，0 不限制（未命中时一次比对全部非常驻模板，时间与用户数成正比）
+  */
+void FPM383TemplateStore::setColdLimit(uint16_t limit)
+{
+    _coldLimit = limit;
+    _coldNext = 0;
+}
+
+/**
+  * @brief   预先将用户模板换入常驻区
+  * @param   user：用户ID
+  * @return  true：用户已在常驻区
+  */
+bool FPM383TemplateStore::pageIn(uint16_t user)
+{
+    if (slotOf(user) != FPM383_NO_ID) return true;
+    if (!hasUser(user) || !downloadUser(user)) return false;
+    uint16_t slot = acquireSlot();
+    if (slot == FPM383_NO_ID || _fpm.storeChar(2, _first + slot) != 0x00) return false;
+    _slotUser[slot] = user;
+    _useCount[slot] = 0;
+    touch(slot);
+    _stats.pageIns++;
+    return true;
+}
+
+bool FPM383TemplateStore::resident(uint16_t user)
+{
+    return slotOf(user) != FPM383_NO_ID;
+}
+
+/**
+  * @brief   最近一次识别成功的比对得分
+  */
+uint16_t FPM383TemplateStore::lastScore()
+{
+    return _score;
+}
+
+const FPM383StoreStats &FPM383TemplateStore::stats()
+{
+    return _stats;
+}
+
+/**
+  * @brief   常驻区命中率 hits / lookups
+  */
+float FPM383TemplateStore::hitRate()
+{
+    return _stats.lookups ? (float)_stats.hits / _stats.lookups : 0.0f;
+}
+
+void FPM383TemplateStore::resetStats()
+{
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+#ifdef ESP32
+
+FPM383FSStorage::FPM383FSStorage(fs::FS &fs, const char *dir) : _fs(fs), _dir(dir)
+{
+}
+
+void FPM383FSStorage::path(uint16_t user, char *buf, size_t size)
+{
+    snprintf(buf, size, "%s/%u.tpl", _dir, (unsigned)user);
+}
+
+bool FPM383FSStorage::load(uint16_t user, uint8_t *buffer, uint32_t capacity, uint32_t *length)
+{
+    char p[48];
+    path(user, p, sizeof(p));
+    File f = _fs.open(p, FILE_READ);
+    if (!f) return false;
+    size_t n = f.size();
+    bool ok = n <= capacity && f.read(buffer, n) == n;
+    f.close();
+    if (ok && length != NULL) *length = n;
+    return ok;
+}
+
+bool FPM383FSStorage::save(uint16_t user, const uint8_t *buffer, uint32_t length)
+{
+    char p[48];
+    path(user, p, sizeof(p));
+    if (!_fs.exists(_dir)) _fs.mkdir(_dir);
+    File f = _fs.open(p, FILE_WRITE);
+    if (!f) return false;
+    bool ok = f.write(buffer, length) == length;
+    f.close();
+    return ok;
+}
+
+bool FPM383FSStorage::remove(uint16_t user)
+{
+    char p[48];
+    path(user, p, sizeof(p));
+    return _fs.remove(p);
+}
+
+bool FPM383FSStorage::list(FPM383UserCallback callback, void *context)
+{
+    File root = _fs.open(_dir);
+    if (!root || !root.isDirectory()) return true;     // 目录不存在，尚无用户
+    for (File f = root.openNextFile(); f; f = root.openNextFile()) {
+        const char *name = f.name();
+        const char *base = strrchr(name, '/');
+        base = base != NULL ? base + 1 : name;
+        char *end;
+        unsigned long user = strtoul(base, &end, 10);
+        if (end == base || strcmp(end, ".tpl") != 0 || user >= FPM383_STORE_UNKNOWN) continue;
+        if (!callback(context, (uint16_t)user)) break;
+    }
+    return true;
+}
+
+#endif // ESP32
+
+#endif // !__AVR__
@@ -0,0 +1,148 @@
+/******************************************************************************
+  fpm383_template_store.h
+  YFROBOT FPM383 Sensor Library Source File
+  Update Date: 04-11-2024
+  @ YFROBOT
+
+  主机端指纹模板库：全部模板保存在主机存储（ESP32 的 SPIFFS/LittleFS/SD，Linux 的文件），
+  模组指纹库中的一段ID作为常驻区，按 LRU/LFU 策略换入常用用户的模板。
+  常驻用户由模组 1:N 搜索直接识别；未命中时逐个下载非常驻模板 1:1 比对，匹配后换入常驻区。
+  每个非常驻模板需一次完整的下载（PS_DownChar）及比对（PS_Match），57600 波特率下约 0.23 s，
+  每次 identify() 最多比对 setColdLimit() 个，其余在之后的调用中继续，单次识别的最长时间与用户数无关。
+
+  受 RAM 限制，AVR 平台不提供本功能。
+
+  Distributed as-is; no warranty is given.
+******************************************************************************/
+
+#ifndef FPM383_TEMPLATE_STORE_H
+#define FPM383_TEMPLATE_STORE_H
+
+#if !defined(__AVR__)
+
+#include "yfrobot_fpm383.h"
+
+#ifdef ESP32
+#include <FS.h>
+#endif
+
+#ifndef FPM383_TEMPLATE_MAX
+#define FPM383_TEMPLATE_MAX     2048    // 模板缓冲区大小（字节）
+#endif
+#ifndef FPM383_STORE_MAX_USERS
+#define FPM383_STORE_MAX_USERS  1024    // 用户ID取值 0 ~ FPM383_STORE_MAX_USERS-1
+#endif
+#ifndef FPM383_STORE_COLD_MAX
+#define FPM383_STORE_COLD_MAX   16      // 每次 identify() 最多比对的非常驻模板数（默认值，见 setColdLimit()）
+#endif
+#ifndef FPM383_STORE_RESUME_GAP
+#define FPM383_STORE_RESUME_GAP 500     // 返回 FPM383_STORE_PARTIAL 后超过该时间（ms）才再次调用，视为新的手指，从头比对
+#endif
+
+// identify() 返回值：用户ID，或以下值
+#define FPM383_STORE_UNKNOWN    0xFFFE  // 有手指，但与所有模板都不匹配
+#define FPM383_STORE_NO_FINGER  0xFFFF  // 无手指或通信失败
+#define FPM383_STORE_PARTIAL    0xFFFD  // 常驻区未命中，已比对 setColdLimit() 个非常驻模板仍未匹配，再次调用继续比对其余模板
+
+// 常驻区换出策略
+#define FPM383_STORE_LRU        0       // 换出最久未使用的模板
+#define FPM383_STORE_LFU        1       // 换出使用次数最少的模板（次数相同时换出最久未使用的）
+
+// 枚举用户回调：返回 false 中止枚举
+typedef bool (*FPM383UserCallback)(void *context, uint16_t user);
+
+// 模板存储接口：每个用户一个模板
+class FPM383TemplateStorage
+{
+  public:
+    virtual ~FPM383TemplateStorage() {}
+    virtual bool load(uint16_t user, uint8_t *buffer, uint32_t capacity, uint32_t *length) = 0;
+    virtual bool save(uint16_t user, const uint8_t *buffer, uint32_t length) = 0;
+    virtual bool remove(uint16_t user) = 0;
+    virtual bool list(FPM383UserCallback callback, void *context) = 0;
+};
+
+#ifdef ESP32
+// ESP32 文件系统存储：dir 目录下每个用户一个文件 "<user>.tpl"，fs 可为 SPIFFS、LittleFS、SD
+class FPM383FSStorage : public FPM383TemplateStorage
+{
+  public:
+    FPM383FSStorage(fs::FS &fs, const char *dir = "/fpm");
+    bool load(uint16_t user, uint8_t *buffer, uint32_t capacity, uint32_t *length);
+    bool save(uint16_t user, const uint8_t *buffer, uint32_t length);
+    bool remove(uint16_t user);
+    bool list(FPM383UserCallback callback, void *context);
+
+  private:
+    fs::FS &_fs;
+    const char *_dir;
+    void path(uint16_t user, char *buf, size_t size);
+};
+#endif
+
+// 命中率统计，用于确定常驻区大小
+struct FPM383StoreStats
+{
+    uint32_t lookups;       // 有手指的识别次数
+    uint32_t hits;          // 常驻区命中（模组 1:N 搜索）
+    uint32_t coldHits;      // 常驻区未命中，下载比对后识别
+    uint32_t misses;        // 未知手指（全部非常驻模板已比对）
+    uint32_t partials;      // 达到比对个数上限，返回 FPM383_STORE_PARTIAL
+    uint32_t pageIns;       // 换入常驻区次数
+    uint32_t evictions;     // 换出次数
+    uint32_t downloads;     // 下载到模组的模板数
+};
+
+class FPM383TemplateStore
+{
+  public:
+    FPM383TemplateStore(YFROBOTFPM383 &fpm, FPM383TemplateStorage &storage,
+                        uint16_t firstSlot, uint16_t slots, uint8_t policy = FPM383_STORE_LRU);
+
+    bool begin();
+    uint8_t enroll(uint16_t user, uint8_t entriesCount);
+    bool add(uint16_t user, const uint8_t *buffer, uint32_t length);
+    bool remove(uint16_t user);
+    bool contains(uint16_t user);
+    uint16_t userCount();
+
+    uint16_t identify(bool searchCold = true);
+    void setColdLimit(uint16_t limit);
+    bool pageIn(uint16_t user);
+    bool resident(uint16_t user);
+    uint16_t lastScore();
+
+    const FPM383StoreStats &stats();
+    float hitRate();
+    void resetStats();
+
+  private:
+    YFROBOTFPM383 &_fpm;
+    FPM383TemplateStorage &_storage;
+    uint16_t _first;                // 常驻区起始ID
+    uint16_t _slots;                // 常驻区大小
+    uint8_t _policy;
+    uint32_t _clock;                // 访问计数，作为 LRU 时间戳
+    uint16_t _score;
+    uint16_t _coldLimit;            // 每次识别最多比对的非常驻模板数，0 不限制
+    uint16_t _coldNext;             // 下一次比对从该用户开始（上一次达到上限时继续）
+    unsigned long _coldAt;          // 上一次返回 FPM383_STORE_PARTIAL 的时间（ms）
+    uint16_t _slotUser[FPM383_MAX_IDS];     // 常驻区各ID中的用户，FPM383_NO_ID 为空
+    uint32_t _lastUse[FPM383_MAX_IDS];
+    uint16_t _useCount[FPM383_MAX_IDS];
+    uint8_t _users[(FPM383_STORE_MAX_USERS + 7) / 8];   // 主机存储中已有模板的用户
+    uint8_t _template[FPM383_TEMPLATE_MAX];
+    FPM383StoreStats _stats;
+
+    static bool listUser(void *context, uint16_t user);
+    bool hasUser(uint16_t user);
+    void markUser(uint16_t user, bool present);
+    uint16_t slotOf(uint16_t user);
+    uint16_t acquireSlot();
+    void touch(uint16_t slot);
+    bool downloadUser(uint16_t user);
+};
+
+#endif // !__AVR__
+
+#endif // FPM383_TEMPLATE_STORE_H
@@ -0,0 +1,103 @@
+/******************************************************************************
+  fpm383_trace.cpp
+  YFROBOT FPM383 Sensor Library Source File
+  Update Date: 04-11-2024
+  @ YFROBOT
+
+  Distributed as-is; no warranty is given.
+******************************************************************************/
+
+#include "fpm383_trace.h"
+
+FPM383TraceTransport::FPM383TraceTransport(FPM383Transport *transport, Print &log)
+    : _transport(transport), _log(log), _recorded(0), _paused(false)
+{
+    _recorded += _log.write((const uint8_t *)FPM383_TRACE_MAGIC, 4);
+    _last = micros();
+}
+
+int FPM383TraceTransport::available()
+{
+    return _transport->available();
+}
+
+int FPM383TraceTransport::read()
+{
+    int data = _transport->read();
+    if (data >= 0) {
+        uint8_t b = data;
+        record(FPM383_TRACE_RX, &b, 1);
+    }
+    return data;
+}
+
+size_t FPM383TraceTransport::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = _transport->write(buffer, size);
+    record(FPM383_TRACE_TX, buffer, n);
+    return n;
+}
+
+void FPM383TraceTransport::setBaudRate(uint32_t baud)
+{
+    _transport->setBaudRate(baud);
+}
+
+void FPM383TraceTransport::listen()
+{
+    _transport->listen();
+}
+
+bool FPM383TraceTransport::exclusive()
+{
+    return _transport->exclusive();
+}
+
+void FPM383TraceTransport::pause()
+{
+    _paused = true;
+}
+
+/**
+  * @brief   继续记录，暂停期间的时间计入下一条记录的间隔
+  */
+void FPM383TraceTransport::resume()
+{
+    _paused = false;
+}
+
+uint32_t FPM383TraceTransport::recorded()
+{
+    return _recorded;
+}
+
+/**
+  * @brief   输出一条记录
+  * @param   dir：FPM383_TRACE_RX / FPM383_TRACE_TX
+  * @param   data：收发的数据
+  * @param   size：字节数，接收记录固定为1
+  */
+void FPM383TraceTransport::record(uint8_t dir, const uint8_t *data, size_t size)
+{
+    unsigned long now = micros();
+    if (_paused) return;
+    uint32_t delta = now - _last;
+    _last = now;
+    if (delta > 0x7FFFFFFFUL) delta = 0x7FFFFFFFUL;
+    writeVarint((delta << 1) | dir);
+    if (dir == FPM383_TRACE_TX) writeVarint(size);
+    _recorded += _log.write(data, size);
+}
+
+void FPM383TraceTransport::writeVarint(uint32_t value)
+{
+    uint8_t buf[5];
+    uint8_t n = 0;
+    do {
+        buf[n] = value & 0x7F;
+        value >>= 7;
+        if (value) buf[n] |= 0x80;
+        n++;
+    } while (value);
+    _recorded += _log.write(buf, n);
+}
@@ -0,0 +1,54 @@
+/******************************************************************************
+  fpm383_trace.h
+  YFROBOT FPM383 Sensor Library Source File
+  Update Date: 04-11-2024
+  @ YFROBOT
+
+  串口记录：包装任意传输接口，记录每个发送/接收字节及时间戳，写入 SD 卡文件、串口等任意 Print。
+  记录用于复现与时序有关的问题（帧被截断、残留字节、噪声），可在 Linux 主机端确定性回放（extras/host/fpm383_replay.h）。
+
+  记录格式：文件头 "FPT1"，之后为连续的记录，整数均为变长编码（每字节低7位，最高位为1表示后面还有字节）
+    接收：varint(间隔us << 1)         1 字节数据
+    发送：varint(间隔us << 1 | 1)     varint(字节数)  数据
+  间隔为距上一条记录（第一条为距开始记录）的微秒数。接收字节的时间为主机读出该字节的时间，发送的时间为写入完成的时间。
+
+  Distributed as-is; no warranty is given.
+******************************************************************************/
+
+#ifndef FPM383_TRACE_H
+#define FPM383_TRACE_H
+
+#include "fpm383_transport.h"
+
+#define FPM383_TRACE_MAGIC      "FPT1"
+#define FPM383_TRACE_RX         0
+#define FPM383_TRACE_TX         1
+
+class FPM383TraceTransport : public FPM383Transport
+{
+  public:
+    // transport：实际传输接口；log：记录输出
+    FPM383TraceTransport(FPM383Transport *transport, Print &log);
+    int available();
+    int read();
+    size_t write(const uint8_t *buffer, size_t size);
+    void setBaudRate(uint32_t baud);
+    void listen();
+    bool exclusive();
+
+    void pause();                   // 暂停记录，收发照常
+    void resume();
+    uint32_t recorded();            // 已输出的记录字节数（含文件头）
+
+  private:
+    FPM383Transport *_transport;
+    Print &_log;
+    unsigned long _last;            // 上一条记录的时间
+    uint32_t _recorded;
+    bool _paused;
+
+    void record(uint8_t dir, const uint8_t *data, size_t size);
+    void writeVarint(uint32_t value);
+};
+
+#endif // FPM383_TRACE_H
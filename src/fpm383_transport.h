@@ -0,0 +1,89 @@
+/******************************************************************************
+  fpm383_transport.h
+  YFROBOT FPM383 Sensor Library Transport Interface
+  Update Date: 04-11-2024
+  @ YFROBOT
+
+  Distributed as-is; no warranty is given.
+******************************************************************************/
+
+#ifndef FPM383_TRANSPORT_H
+#define FPM383_TRANSPORT_H
+
+#include "Arduino.h"
+
+#ifdef __AVR__
+#include <SoftwareSerial.h>
+#elif defined(ESP32)
+#include <HardwareSerial.h>
+#endif
+
+// 字节流传输接口：库只通过此接口收发数据，可替换为任意串口、模拟器或记录/回放实现
+class FPM383Transport
+{
+  public:
+    virtual ~FPM383Transport() {}
+    virtual int available() = 0;                                // 可读字节数
+    virtual int read() = 0;                                     // 读一个字节，无数据返回-1
+    virtual size_t write(const uint8_t *buffer, size_t size) = 0;
+    virtual void setBaudRate(uint32_t baud) { (void)baud; }    // 切换主机端波特率，不支持时忽略
+    virtual void listen() {}                                    // 多个软串口时切换监听对象
+    virtual bool exclusive() { return false; }                  // 同一时刻只有一个实例能接收（软串口），调度器据此串行化
+};
+
+// 任意 Arduino Stream 适配（HardwareSerial、USB CDC 等），波特率由调用者自行设置
+class FPM383StreamTransport : public FPM383Transport
+{
+  public:
+    FPM383StreamTransport(Stream *stream) : _stream(stream) {}
+    int available() { return _stream->available(); }
+    int read() { return _stream->read(); }
+    size_t write(const uint8_t *buffer, size_t size) { return _stream->write(buffer, size); }
+
+  protected:
+    Stream *_stream;
+};
+
+#ifdef __AVR__
+// AVR 软件串口，自定义引脚
+class FPM383SoftwareSerialTransport : public FPM383Transport
+{
+  public:
+    FPM383SoftwareSerialTransport(int rxPin, int txPin) : _serial(rxPin, txPin) {}
+    int available() { return _serial.available(); }
+    int read() { return _serial.read(); }
+    size_t write(const uint8_t *buffer, size_t size) { return _serial.write(buffer, size); }
+    void setBaudRate(uint32_t baud) { _serial.begin(baud); }
+    void listen() { _serial.listen(); }
+    bool exclusive() { return true; }
+
+  private:
+    SoftwareSerial _serial;
+};
+#endif
+
+#if defined(__AVR__) || defined(ESP32)
+// 硬件串口，模组串口格式为 8N2；ESP32 可自定义引脚，-1 为该串口默认引脚，AVR 忽略引脚参数
+// 各硬件串口独立收发，多个模组可同时进行操作
+class FPM383HardwareSerialTransport : public FPM383Transport
+{
+  public:
+    FPM383HardwareSerialTransport(HardwareSerial *serial, int rxPin = -1, int txPin = -1)
+        : _serial(serial), _pin_rx(rxPin), _pin_tx(txPin) {}
+    int available() { return _serial->available(); }
+    int read() { return _serial->read(); }
+    size_t write(const uint8_t *buffer, size_t size) { return _serial->write(buffer, size); }
+#ifdef ESP32
+    void setBaudRate(uint32_t baud) { _serial->begin(baud, SERIAL_8N2, _pin_rx, _pin_tx); }
+#else
+    void setBaudRate(uint32_t baud) { _serial->begin(baud, SERIAL_8N2); }
+#endif
+
+  private:
+    HardwareSerial *_serial;
+    int _pin_rx;
+    int _pin_tx;
+};
+#endif
+
+#endif // FPM383_TRANSPORT_H
@@ -0,0 +1,329 @@
+/******************************************************************************
+  fpm383_worker.cpp
+  YFROBOT FPM383 Sensor Library Source File
+  Update Date: 04-11-2024
+  @ YFROBOT
+
+  Distributed as-is; no warranty is given.
+******************************************************************************/
+
+#include "fpm383_worker.h"
+
+#if defined(ESP32) || defined(FPM383_HOST)
+
+#ifdef FPM383_HOST
+#include <chrono>
+#endif
+
+// 等待其他任务时让出处理器
+static void workerPause()
+{
+#ifdef ESP32
+    vTaskDelay(1);
+#else
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+#endif
+}
+
+// 等待应答时两次 poll() 之间让出处理器：ESP32 让同核低优先级任务（loopTask）运行，
+// Linux 虚拟时钟由轮询推进，只让出时间片
+static void pollPause()
+{
+#ifdef ESP32
+    vTaskDelay(1);
+#else
+    std::this_thread::yield();
+#endif
+}
+
+FPM383Future::FPM383Future() : _ready(false), _result(0xFF), _score(0)
+{
+}
+
+bool FPM383Future::ready()
+{
+    return _ready.load(std::memory_order_acquire);
+}
+
+/**
+  * @brief   等待指令完成
+  * @param   timeout：超时时间（ms）
+  * @return  true：已完成
+  */
+bool FPM383Future::wait(uint32_t timeout)
+{
+    unsigned long start = millis();
+    while (!ready()) {
+        if (millis() - start >= timeout) return false;
+        workerPause();
+    }
+    return true;
+}
+
+uint8_t FPM383Future::get()
+{
+    while (!ready()) workerPause();
+    return _result;
+}
+
+uint16_t FPM383Future::score()
+{
+    return ready() ? _score : 0;
+}
+
+FPM383Worker::FPM383Worker(YFROBOTFPM383 &fpm)
+    : _fpm(fpm), _running(false), _closed(true), _submitting(0), _led(0), _ledPending(false), _ledRequests(0), _ledSent(0)
+#ifdef ESP32
+    , _task(NULL), _exited(true)
+#endif
+{
+}
+
+FPM383Worker::~FPM383Worker()
+{
+    end();
+}
+
+/**
+  * @brief   启动后台任务
+  * @param   core：ESP32 运行的核，-1 不指定
+  * @param   priority：ESP32 任务优先级
+  * @return  true：已启动
+  */
+bool FPM383Worker::begin(int core, uint8_t priority)
+{
+    if (_running) return true;
+    _running = true;
+    _closed = false;
+#ifdef ESP32
+    _exited = false;
+    BaseType_t ok = core < 0
+        ? xTaskCreate(taskEntry, "fpm383", FPM383_WORKER_STACK, this, priority, &_task)
+        : xTaskCreatePinnedToCore(taskEntry, "fpm383", FPM383_WORKER_STACK, this, priority, &_task, core);
+    if (ok != pdPASS) {
+        _running = false;
+        _exited = true;
+        return false;
+    }
+#else
+    (void)core;
+    (void)priority;
+    _thread = std::thread(taskEntry, this);
+#endif
+    return true;
+}
+
+/**
+  * @brief   停止后台任务：正在执行的指令完成后退出，队列中未执行的指令以 FPM383_RESULT_CANCELLED 完成
+  */
+void FPM383Worker::end()
+{
+    if (!_running) return;
+    _closed = true;             // 之后的 submit() 返回 false，等待已通过检查的调用者入队后再清空队列
+    while (_submitting.load() > 0) workerPause();
+    _running = false;
+    wake();
+#ifdef ESP32
+    while (!_exited) workerPause();
+    _task = NULL;
+#else
+    if (_thread.joinable()) _thread.join();
+#endif
+    FPM383Job job;
+    while (_queue.pop(job)) complete(job, FPM383_RESULT_CANCELLED, 0);
+}
+
+bool FPM383Worker::running()
+{
+    return _running;
+}
+
+void FPM383Worker::taskEntry(void *arg)
+{
+    ((FPM383Worker *)arg)->run();
+#ifdef ESP32
+    ((FPM383Worker *)arg)->_exited = true;
+    vTaskDelete(NULL);
+#endif
+}
+
+/**
+  * @brief   后台任务主循环：先发送最新 LED 状态，再依次执行队列中的指令
+  */
+void FPM383Worker::run()
+{
+    while (_running) {
+        sendLED();
+        FPM383Job job;
+        if (_queue.pop(job)) {
+            execute(job);
+        } else {
+            idle();
+        }
+    }
+}
+
+/**
+  * @brief   唤醒等待中的后台任务
+  */
+void FPM383Worker::wake()
+{
+#ifdef ESP32
+    if (_task != NULL) xTaskNotifyGive(_task);
+#endif
+}
+
+/**
+  * @brief   无指令时等待：ESP32 阻塞至 wake()，Linux 短暂休眠
+  */
+void FPM383Worker::idle()
+{
+#ifdef ESP32
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+#else
+    workerPause();
+#endif
+}
+
+bool FPM383Worker::submit(uint8_t op, uint8_t arg, uint16_t id, FPM383Future *future,
+                          FPM383WorkerCallback callback, void *context)
+{
+    _submitting++;
+    if (_closed.load()) {
+        _submitting--;
+        return false;
+    }
+    FPM383Job job = { op, arg, id, future, callback, context };
+    if (future != NULL) future->_ready.store(false, std::memory_order_relaxed);
+    bool ok = _queue.push(job);
+    _submitting--;
+    if (ok) wake();
+    return ok;
+}
+
+/**
+  * @brief   提交识别指令（分步式，同 identify()）
+  */
+bool FPM383Worker::identify(bool NoFingerLED, FPM383Future *future, FPM383WorkerCallback callback, void *context)
+{
+    return submit(FPM383_OP_IDENTIFY, NoFingerLED, 0, future, callback, context);
+}
+
+/**
+  * @brief   提交自动验证指令（同 autoIdentify()，默认安全等级及超时）
+  */
+bool FPM383Worker::autoIdentify(bool NoFingerLED, uint16_t PageID, FPM383Future *future,
+                                FPM383WorkerCallback callback, void *context)
+{
+    return submit(FPM383_OP_AUTO_IDENTIFY, NoFingerLED, PageID, future, callback, context);
+}
+
+/**
+  * @brief   提交注册指令（同 enroll()）
+  */
+bool FPM383Worker::enroll(uint16_t PageID, uint8_t entriesCount, FPM383Future *future,
+                          FPM383WorkerCallback callback, void *context)
+{
+    return submit(FPM383_OP_ENROLL, entriesCount, PageID, future, callback, context);
+}
+
+/**
+  * @brief   提交删除指令（同 deleteID()）
+  */
+bool FPM383Worker::deleteID(uint16_t PageID, FPM383Future *future, FPM383WorkerCallback callback, void *context)
+{
+    return submit(FPM383_OP_DELETE, 0, PageID, future, callback, context);
+}
+
+/**
+  * @brief   提交清空指纹库指令（同 empty()）
+  */
+bool FPM383Worker::empty(FPM383Future *future, FPM383WorkerCallback callback, void *context)
+{
+    return submit(FPM383_OP_EMPTY, 0, 0, future, callback, context);
+}
+
+/**
+  * @brief   设置 LED 状态，参数同 controlLEDC()；后台任务执行下一条指令前发送最新状态
+  */
+void FPM383Worker::led(uint8_t fun, uint8_t start, uint8_t end, uint8_t cycle)
+{
+    _led.store(fun | (start << 8) | ((uint32_t)end << 16) | ((uint32_t)cycle << 24), std::memory_order_relaxed);
+    _ledPending.store(true, std::memory_order_release);
+    _ledRequests++;
+    wake();
+}
+
+uint16_t FPM383Worker::pending()
+{
+    return _queue.size();
+}
+
+uint32_t FPM383Worker::ledRequests()
+{
+    return _ledRequests;
+}
+
+uint32_t FPM383Worker::ledSent()
+{
+    return _ledSent;
+}
+
+/**
+  * @brief   有新的 LED 状态时发送
+  */
+void FPM383Worker::sendLED()
+{
+    if (!_ledPending.exchange(false, std::memory_order_acquire)) return;
+    uint32_t state = _led.load(std::memory_order_relaxed);
+    _fpm.controlLEDC(state, state >> 8, state >> 16, state >> 24);
+    _ledSent++;
+}
+
+void FPM383Worker::execute(const FPM383Job &job)
+{
+    uint8_t result = 0xFF;
+    uint16_t score = 0;
+    switch (job.op) {
+        case FPM383_OP_IDENTIFY:
+            if (_fpm.beginIdentify(job.arg)) result = finish();
+            if (result < FPM383_RESULT_CANCELLED) score = _fpm.score();     // 失败时不沿用上次识别成功的得分
+            break;
+        case FPM383_OP_AUTO_IDENTIFY:
+            if (_fpm.beginAutoIdentify(job.arg, FPM383_SECURITY_DEFAULT, job.id)) result = finish();
+            if (result < FPM383_RESULT_CANCELLED) score = _fpm.score();
+            break;
+        case FPM383_OP_ENROLL:
+            if (_fpm.beginEnroll(job.id, job.arg)) result = finish();
+            break;
+        case FPM383_OP_DELETE:
+            result = _fpm.deleteID(job.id);
+            break;
+        case FPM383_OP_EMPTY:
+            result = _fpm.empty();
+            break;
+    }
+    complete(job, result, score);
+}
+
+/**
+  * @brief   推进已开始的异步操作直至完成，每次 poll() 之间让出处理器，不阻塞同核的其他任务
+  * @return  操作结果，同对应的同步函数
+  */
+uint8_t FPM383Worker::finish()
+{
+    while (_fpm.poll() == FPM383_BUSY) pollPause();
+    return _fpm.result();
+}
+
+void FPM383Worker::complete(const FPM383Job &job, uint8_t result, uint16_t score)
+{
+    if (job.future != NULL) {
+        job.future->_result = result;
+        job.future->_score = score;
+        job.future->_ready.store(true, std::memory_order_release);
+    }
+    if (job.callback != NULL) job.callback(job.context, job.op, result);
+}
+
+#endif // ESP32 || FPM383_HOST
@@ -0,0 +1,194 @@
+/******************************************************************************
+  fpm383_worker.h
+  YFROBOT FPM383 Sensor Library Source File
+  Update Date: 04-11-2024
+  @ YFROBOT
+
+  后台任务模式：由独立任务（ESP32 为 FreeRTOS 任务，Linux 为 std::thread）独占模组串口，
+  其他任务通过无锁队列提交指令，结果通过 FPM383Future 或回调返回。识别、注册由后台任务调用 begin*() 后
+  循环 poll()，每次之间让出处理器（ESP32 vTaskDelay(1)），等待手指的数秒内同一核上的 loop() 照常运行。
+  LED 指令不进入队列，只保存最新状态，后台任务执行下一条指令前发送，连续多次设置只发送最后一次。
+
+  仅 ESP32 及 Linux 主机端构建提供。
+
+  Distributed as-is; no warranty is given.
+******************************************************************************/
+
+#ifndef FPM383_WORKER_H
+#define FPM383_WORKER_H
+
+#include "yfrobot_fpm383.h"
+
+#if defined(ESP32) || defined(FPM383_HOST)
+#include <atomic>
+
+#ifdef FPM383_HOST
+#include <thread>
+#endif
+
+#ifndef FPM383_WORKER_QUEUE
+#define FPM383_WORKER_QUEUE     16      // 指令队列长度，须为2的幂
+#endif
+#define FPM383_WORKER_STACK     4096    // ESP32 任务栈大小（字节）
+#define FPM383_WORKER_PRIORITY  2       // ESP32 任务优先级，高于 loopTask（1）；等待应答期间每次 poll() 后让出处理器
+#define FPM383_WORKER_CORE      1       // ESP32 默认运行在 APP 核（与 loop() 相同），WiFi/蓝牙协议栈运行在核0
+
+// 后台任务指令（回调 op 参数），识别、注册与异步操作类型相同
+#define FPM383_OP_DELETE        5       // deleteID()
+#define FPM383_OP_EMPTY         6       // empty()
+
+// 指令完成回调，在后台任务中调用：result 与同步函数返回值含义相同，后台任务停止时未执行的指令为 FPM383_RESULT_CANCELLED
+typedef void (*FPM383WorkerCallback)(void *context, uint8_t op, uint8_t result);
+
+// 指令结果：由调用者分配，指令完成前须保持有效
+class FPM383Future
+{
+  public:
+    FPM383Future();
+    bool ready();
+    bool wait(uint32_t timeout);    // 等待完成，超时返回 false
+    uint8_t get();                  // 等待完成并返回结果
+    uint16_t score();               // 识别成功时的比对得分
+
+  private:
+    friend class FPM383Worker;
+    std::atomic<bool> _ready;
+    uint8_t _result;
+    uint16_t _score;
+};
+
+struct FPM383Job
+{
+    uint8_t op;                     // FPM383_OP_*
+    uint8_t arg;                    // 识别：无手指时是否闪灯；注册：拼接次数
+    uint16_t id;
+    FPM383Future *future;
+    FPM383WorkerCallback callback;
+    void *context;
+};
+
+// 有界多生产者多消费者无锁队列（每格带序号），N 须为2的幂
+template <typename T, uint16_t N>
+class FPM383Queue
+{
+  public:
+    FPM383Queue() : _head(0), _tail(0)
+    {
+        for (uint16_t i = 0; i < N; i++) _cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    bool push(const T &item)
+    {
+        uint32_t pos = _tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = _cells[pos & (N - 1)];
+            int32_t diff = (int32_t)(cell.seq.load(std::memory_order_acquire) - pos);
+            if (diff == 0) {
+                if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.item = item;
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;       // 队列已满
+            } else {
+                pos = _tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool pop(T &item)
+    {
+        uint32_t pos = _head.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = _cells[pos & (N - 1)];
+            int32_t diff = (int32_t)(cell.seq.load(std::memory_order_acquire) - (pos + 1));
+            if (diff == 0) {
+                if (_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    item = cell.item;
+                    cell.seq.store(pos + N, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;       // 队列为空
+            } else {
+                pos = _head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    uint16_t size()
+    {
+        return (uint16_t)(_tail.load(std::memory_order_relaxed) - _head.load(std::memory_order_relaxed));
+    }
+
+  private:
+    struct Cell {
+        std::atomic<uint32_t> seq;
+        T item;
+    };
+    Cell _cells[N];
+    std::atomic<uint32_t> _head;
+    std::atomic<uint32_t> _tail;
+};
+
+class FPM383Worker
+{
+  public:
+    FPM383Worker(YFROBOTFPM383 &fpm);
+    ~FPM383Worker();
+
+    // 启动后台任务，此后只能通过本对象访问模组；core、priority 仅 ESP32 有效
+    bool begin(int core = FPM383_WORKER_CORE, uint8_t priority = FPM383_WORKER_PRIORITY);
+    void end();
+    bool running();
+
+    // 提交指令，可在任意任务中调用，立即返回；队列已满或后台任务未启动返回 false
+    bool identify(bool NoFingerLED, FPM383Future *future = NULL,
+                  FPM383WorkerCallback callback = NULL, void *context = NULL);
+    bool autoIdentify(bool NoFingerLED, uint16_t PageID = FPM383_SEARCH_ALL, FPM383Future *future = NULL,
+                      FPM383WorkerCallback callback = NULL, void *context = NULL);
+    bool enroll(uint16_t PageID, uint8_t entriesCount, FPM383Future *future = NULL,
+                FPM383WorkerCallback callback = NULL, void *context = NULL);
+    bool deleteID(uint16_t PageID, FPM383Future *future = NULL,
+                  FPM383WorkerCallback callback = NULL, void *context = NULL);
+    bool empty(FPM383Future *future = NULL, FPM383WorkerCallback callback = NULL, void *context = NULL);
+    // 设置 LED 状态，参数同 controlLEDC()；只保存最新状态，不占用队列
+    void led(uint8_t fun, uint8_t start, uint8_t end, uint8_t cycle);
+
+    uint16_t pending();             // 队列中未执行的指令数
+    uint32_t ledRequests();         // led() 调用次数
+    uint32_t ledSent();             // 实际发送的 LED 指令数
+
+  private:
+    YFROBOTFPM383 &_fpm;
+    FPM383Queue<FPM383Job, FPM383_WORKER_QUEUE> _queue;
+    std::atomic<bool> _running;
+    std::atomic<bool> _closed;      // end() 开始后拒绝新的指令
+    std::atomic<uint8_t> _submitting;   // 正在 submit() 中的调用者数
+    std::atomic<uint32_t> _led;     // 最新 LED 状态：功能码 | 起始颜色<<8 | 结束颜色<<16 | 循环次数<<24
+    std::atomic<bool> _ledPending;
+    std::atomic<uint32_t> _ledRequests;
+    std::atomic<uint32_t> _ledSent;
+#ifdef ESP32
+    TaskHandle_t _task;
+    std::atomic<bool> _exited;
+#else
+    std::thread _thread;
+#endif
+
+    static void taskEntry(void *arg);
+    void run();
+    void wake();
+    void idle();
+    bool submit(uint8_t op, uint8_t arg, uint16_t id, FPM383Future *future,
+                FPM383WorkerCallback callback, void *context);
+    void sendLED();
+    void execute(const FPM383Job &job);
+    uint8_t finish();
+    void complete(const FPM383Job &job, uint8_t result, uint16_t score);
+};
+
+#endif // ESP32 || FPM383_HOST
+
+#endif // FPM383_WORKER_H
@@ -9,7 +9,134 @@
 
 #include "yfrobot_fpm383.h"
 
+// 异步操作步骤，表示当前正在等待哪条指令的应答包
+#define STEP_GET_IMAGE      1   // 获取图像 0x01
+#define STEP_GET_CHAR       2   // 生成特征 0x02
+#define STEP_SEARCH         3   // 搜索指纹 0x04
+#define STEP_AUTO_ENROLL    5   // 自动注册 0x31
+#define STEP_AUTO_IDENTIFY  6   // 自动验证 0x32
+#define STEP_CANCEL         7   // 取消 0x30，丢弃自动注册/自动验证剩余的状态包
+#define STEP_DISCARD        8   // 已取消，丢弃当前指令的应答包后结束
+#define STEP_SLEEP          9   // 休眠 0x33
+#define STEP_ACKS           10  // 等待之前流水线指令的应答，之后发送 _asyncNext 步骤的指令
 
+#define SEND_PACKET(P)      sendPacket_P(P::data, P::SIZE)
+// 流水线发送：不等待应答，应答到达时由 consumeAck() 计数丢弃（LED、休眠、超时后的取消）
+#define SEND_PIPELINED(P)   do { sendPacket_P(P::data, P::SIZE, true); pipelined(); } while (0)
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR           // ESP32 中断函数放入 IRAM，其他平台无需
+#endif
+
+// 通信统计语句，FPM383_STATS 为0时不编译
+#if FPM383_STATS
+#define FPM383_STAT(x)      do { x; } while (0)
+#else
+#define FPM383_STAT(x)      do { } while (0)
+#endif
+
+// 功耗统计语句，FPM383_POWER 为0时不编译
+#if FPM383_POWER
+#define FPM383_POWER_STAT(x) do { x; } while (0)
+#else
+#define FPM383_POWER_STAT(x) do { } while (0)
+#endif
+
+/********************************************** 指纹模块 指令集 ************************************************/
+//指令/命令包格式：                  包头0xEF01  设备地址4bytes 包标识1byte 包长度2bytes 指令码1byte  参数1......参数N  校验和2bytes
+//固定指令包由 FPM383Packet<指令码, 参数...> 在编译期生成包长度和校验和，存放于 flash
+
+//获取芯片唯一序列号 0x34。确认码=00H 表示 OK；确认码=01H 表示收包有错。
+typedef FPM383Packet<0x34, 0x00> PS_GetChipSN;
+//获取模组基本参数 0x0F，读取模组的基本参数（波特率，包大小等）。参数表前 16 个字节存放了模组的基本通讯和配置信息，称为模组的基本参数。
+//应答：确认码 状态寄存器(2) 系统标识码(2) 指纹库大小(2) 安全等级(2) 设备地址(4) 数据包大小(2，0~3 对应32/64/128/256字节) 波特率(2，N*9600)
+typedef FPM383Packet<0x0F> PS_ReadSysPara;
+#define SYS_PARA_CAPACITY       4       // 各参数在应答参数中的偏移
+#define SYS_PARA_SECURITY       6
+#define SYS_PARA_PACKET_SIZE    12
+//验证用获取图像 0x01，验证指纹时，探测手指，探测到后录入指纹图像存于图像缓冲区。返回确认码表示：录入成功、无手指等。
+typedef FPM383Packet<0x01> PS_GetImage;
+// 生成特征 0x02，将图像缓冲区中的原始图像生成指纹特征文件存于模板缓冲区1。
+typedef FPM383Packet<0x02, 0x01> PS_GetChar;
+// 搜索指纹 0x04，以模板缓冲区中的特征文件搜索整个或部分指纹库。若搜索到，则返回页码。加密等级设置为 0 或 1 情况下支持此功能。
+//                          缓冲区  起始页      页数
+typedef FPM383Packet<0x04, 0x01, 0x00, 0x00, 0xFF, 0xFF> PS_SearchMB;
+#define PS_SEARCH               0x04    // 搜索部分指纹库时运行时组包
+// 储存模板 0x06，将特征缓冲区中的模板存入 flash 指纹库，参数：缓冲区号(1) ID号(2)
+#define PS_STORE_CHAR           0x06
+// 读出模板 0x07，将 flash 指纹库中的模板读入特征缓冲区，参数：缓冲区号(1) ID号(2)
+#define PS_LOAD_CHAR            0x07
+// 上传特征或模板 0x08，参数：缓冲区号(1)。应答包之后模组连续发送数据包(0x02)，最后一包为结束包(0x08)
+#define PS_UP_CHAR              0x08
+// 下载特征或模板 0x09，参数：缓冲区号(1)。应答包之后主机连续发送数据包(0x02)，最后一包为结束包(0x08)
+#define PS_DOWN_CHAR            0x09
+// 上传图像 0x0A，上传图像缓冲区中的原始图像。应答包之后模组连续发送数据包(0x02)，最后一包为结束包(0x08)
+#define PS_UP_IMAGE             0x0A
+// 读索引表 0x1F，参数：索引页(1)，每页32字节对应256个ID，字节0的bit0对应ID 0；应答：确认码 索引表(32)
+#define PS_READ_INDEX_TABLE     0x1F
+#define INDEX_PAGE_IDS          256
+// 写系统寄存器 0x0E，参数：寄存器序号(1) 内容(1)。寄存器4：波特率控制，N*9600；寄存器5：安全等级；寄存器6：数据包大小
+// 修改波特率时，模组先以原波特率返回应答包，再切换到新波特率
+#define PS_WRITE_REG            0x0E
+#define REG_BAUD                4
+#define REG_PACKET_SIZE         6
+// 精确比对 0x03，比对特征缓冲区1与缓冲区2中的特征或模板；应答：确认码 得分(2)
+typedef FPM383Packet<0x03> PS_Match;
+// 删除指纹 0x0C，删除 flash 数据库中指定 ID 号开始的 N 个指纹模板，参数：起始ID(2) 个数(2)，运行时组包
+#define PS_DELETE               0x0C
+// 清空指纹库 0x0D，删除 flash 数据库中所有指纹模板。
+typedef FPM383Packet<0x0D> PS_Empty;
+// 读有效模板个数 0x1D，读有效模板个数。
+typedef FPM383Packet<0x1D> PS_ValidTempleteNum;
+// 取消指令 0x30，取消自动注册模板和自动验证指纹。加密等级设置为 0 或 1 情况下支持此功能。
+typedef FPM383Packet<0x30> PS_Cancel;
+// 自动注册 0x31，一站式注册指纹，包含采集指纹、生成特征、组合模板、存储模板等功能。加密等级设置为 0 或 1 情况下支持此功能。
+// 参数：ID号(2) 录入次数(1) 参数(2)，运行时组包
+// 录入次数：1~12，推荐值4~6
+// 参数说明：最低位为 bit0。
+//     1) bit0：采图背光灯控制位，0-LED 长亮，1-LED 获取图像成功后灭；
+//     2) bit1：采图预处理控制位，0-关闭预处理，1-打开预处理；
+//     3) bit2：注册过程中，是否要求模组在关键步骤，返回当前状态，0-要求返回，1-不要求返回；
+//     4) bit3：是否允许覆盖 ID 号，0-不允许，1-允许；
+//     5) bit4：允许指纹重复注册控制位，0-允许，1-不允许；
+//     6) bit5：注册时，多次指纹采集过程中，是否要求手指离开才能进入下一次指纹图 像采集， 0-要求离开；1-不要求离开；
+//     7) bit6~bit15：预留。
+// 当前值为 0x17，0001 0111；灯光获取成功后熄灭，打开预处理，不要求返回状态，不允许覆盖ID，不允许重复注册，多次采集手指需要离开
+// 设置了进度回调时清除 bit2，模组在每个关键步骤返回状态包：确认码 步骤(参数1) 采集次数(参数2)，最后一包为存储模板 0x06 0xF2
+#define PS_AUTO_ENROLL          0x31
+#define PS_AUTO_ENROLL_FLAGS    0x0017
+#define PS_AUTO_ENROLL_STATUS   0x0004
+// 自动验证指纹 0x32，一站式采集指纹、生成特征并与指纹库比对，一次往返返回ID号及得分。加密等级设置为 0 或 1 情况下支持此功能。
+// 参数：分数等级(1) ID号(2，0xFFFF为1:N搜索) 参数(2)，运行时组包
+// 参数说明：bit0 采图背光灯控制位，0-LED 长亮，1-LED 获取图像成功后灭；bit1 采图预处理控制位；
+//          bit2 是否在关键步骤返回当前状态，0-要求返回，1-不要求返回
+// 应答：确认码 参数(当前步骤) ID号(2) 得分(2)
+// 当前值为 0x0007；灯光获取成功后熄灭，打开预处理，不要求返回状态
+#define PS_AUTO_IDENTIFY        0x32
+#define PS_AUTO_IDENTIFY_FLAGS  0x0007
+// 休眠指令 0x33，设置传感器进入休眠模式。
+typedef FPM383Packet<0x33> PS_Sleep;
+// LED控制灯指令  0x3C，控制灯指令主要分为两类：一般指示灯和七彩编程呼吸灯。
+// 指令说明
+// 功能码：LED 灯模式控制位，1-普通呼吸灯，2-闪烁灯，3-常开灯，4-常闭灯，5-渐开灯，6-渐闭灯，其他功能码不适用于此指令包格式；
+// 起始颜色：设置为普通呼吸灯时，由灭到亮的颜色，只限于普通呼吸灯（功能码 01）功能，其他功能时，与结束颜色保持一致。
+//      其中，bit0 是蓝灯控制位；bit1 是绿灯控制位；bit2 是红灯控制位。置 1 灯亮，置 0 灯灭。
+//      例如 0x01_蓝灯亮，0x02_绿灯亮，0x04_红灯亮，0x06_红绿灯亮，0x05_红蓝灯亮，0x03_绿蓝灯亮，0x07_红绿蓝灯亮，0x00_全灭；
+// 结束颜色：设置为普通呼吸灯时，由亮到灭的颜色，只限于普通呼吸灯（功能码 0x01），其他功能时，与起始颜色保持一致。设置方式与起始颜色一样；
+// 循环次数：表示呼吸或者闪烁灯的次数。当设为 0 时，表示无限循环，当设为其他值时，
+// 表示呼吸有限次数。循环次数适用于呼吸、闪烁功能，其他功能中无效，例如在常开、常闭、渐开和渐闭中是无效的；
+// 指令说明                       功能  起始  结束  循环
+#define PS_CONTROL_LED          0x3C
+typedef FPM383Packet<0x3C, 0x01, 0x02, 0x01, 0x02> PS_COLORLED;     // 呼吸灯 绿到蓝色
+typedef FPM383Packet<0x3C, 0x03, 0x01, 0x01, 0x00> PS_BlueLED;      // 常开 蓝色
+typedef FPM383Packet<0x3C, 0x02, 0x06, 0x06, 0x01> PS_RGLEDBlink;   // 闪烁1次 红绿色
+typedef FPM383Packet<0x3C, 0x02, 0x04, 0x04, 0x02> PS_RedLED;       // 闪烁2次 红色
+typedef FPM383Packet<0x3C, 0x02, 0x04, 0x04, 0x00> PS_RedLEDLOOP;   // 循环闪烁闪烁 红色
+typedef FPM383Packet<0x3C, 0x02, 0x02, 0x02, 0x02> PS_GreenLED;     // 闪烁2次 绿色
+typedef FPM383Packet<0x3C, 0x04, 0x00, 0x00, 0x00> PS_OFFLED;       // 全灭
+
+
+#if defined(__AVR__) || defined(ESP32)
 YFROBOTFPM383::YFROBOTFPM383(int rxPin, int txPin)
 {
     this->_pin_rx = rxPin;
@@ -20,68 +147,628 @@ YFROBOTFPM383::YFROBOTFPM383(int rxPin, int txPin)
     // 这可能包括设置引脚为输入/输出，初始化通信速率等
     pinMode(this->_pin_rx, INPUT);
     pinMode(this->_pin_tx, OUTPUT);
-    _ss = new SERIAL_CLASS(this->_pin_rx,  this->_pin_tx);
-    _ss->begin(57600);
+    _ss = _owned = new FPM383SoftwareSerialTransport(this->_pin_rx,  this->_pin_tx);
 
 #elif defined(ESP32)    // ESP32 硬件串口2 自定义引脚
-    // Serial.begin(9600);
-
     // 初始化 ESP32 的硬件串口2
-    _ss = &Serial2;
     // 设置引脚为输入输出模式
     pinMode(this->_pin_rx, INPUT);
     pinMode(this->_pin_tx, OUTPUT);
+    _ss = _owned = new FPM383HardwareSerialTransport(&Serial2, this->_pin_rx, this->_pin_tx);
+#endif
     // 开始串口通信
-    _ss->begin(57600, SERIAL_8N2, this->_pin_rx, this->_pin_tx);
-    // Serial.println("Serial2 init success");
+    _ss->setBaudRate(FPM383_BAUD_DEFAULT);
+    init();
+}
+
+/**
+  * @brief   使用指定硬件串口构造，每个模组独占一个串口，多个模组可同时工作
+  * @param   serial：硬件串口，如 Serial1、Serial2
+  * @param   rxPin、txPin：ESP32 自定义引脚，-1 使用该串口默认引脚；AVR 忽略
+  */
+YFROBOTFPM383::YFROBOTFPM383(HardwareSerial &serial, int rxPin, int txPin)
+{
+    this->_pin_rx = rxPin;
+    this->_pin_tx = txPin;
+    _ss = _owned = new FPM383HardwareSerialTransport(&serial, rxPin, txPin);
+    _ss->setBaudRate(FPM383_BAUD_DEFAULT);
+    init();
+}
 #endif
 
+/**
+  * @brief   使用任意 Stream 构造（USB CDC、其他串口库等），串口需由调用者以模组波特率初始化
+  * @param   stream：串口
+  */
+YFROBOTFPM383::YFROBOTFPM383(Stream &stream)
+{
+    this->_pin_rx = -1;
+    this->_pin_tx = -1;
+    _ss = _owned = new FPM383StreamTransport(&stream);
+    init();
+}
+
+/**
+  * @brief   使用自定义传输接口构造，例如模拟器、记录/回放或其他串口
+  * @param   transport：传输接口，生命周期由调用者管理
+  */
+YFROBOTFPM383::YFROBOTFPM383(FPM383Transport *transport)
+{
+    this->_pin_rx = -1;
+    this->_pin_tx = -1;
+    _ss = transport;
+    _owned = NULL;
+    init();
+}
+
+YFROBOTFPM383::~YFROBOTFPM383()
+{
+    touchEnd();
+    delete _owned;
+}
+
+/**
+  * @brief   初始化帧解析器及异步操作状态
+  */
+void YFROBOTFPM383::init()
+{
+    resetReceive();
+    _rxReplay = 0;
+    _rxReplayEnd = 0;
+    _asyncOp = FPM383_OP_NONE;
+    _asyncStep = 0;
+    _asyncResult = 0xFF;
+    _asyncScore = 0;
+    _asyncNoFingerLED = false;
+    _searchStart = 0;
+    _searchCount = FPM383_SEARCH_ALL;
+    _asyncTimeout = 0;
+    _asyncStart = 0;
+    _asyncNext = 0;
+    _asyncNextTimeout = 0;
+    _asyncNextParams = 0;
+    _autoSecurity = FPM383_SECURITY_DEFAULT;
+    _autoPageID = FPM383_SEARCH_ALL;
+    _callback = NULL;
+    _progress = NULL;
+    _enrollID = 0;
+    _enrollCount = 0;
+    _enrollStatus = false;
+    memset(_enrollReply, 0xFF, sizeof(_enrollReply));
+    _baud = FPM383_BAUD_DEFAULT;
+    _packetSize = FPM383_PACKET_SIZE_DEFAULT;
+    _sinkActive = false;
+    _transferBytes = 0;
+    _transferMicros = 0;
+    _capacity = FPM383_CAPACITY_DEFAULT;
+    _securityLevel = FPM383_SECURITY_DEFAULT;
+    _sysParaValid = false;
+    memset(_index, 0, sizeof(_index));
+    _indexValid = false;
+    _pendingAcks = 0;
+    _ackSent = 0;
+    _acksLost = 0;
+    _expectParams = 0;
+    _lastError = FPM383_ERROR_NONE;
+    _rxError = false;
+    _rxAny = false;
+    _touchPin = -1;
+    _touched = false;
+    _touchInterrupt = false;
+    _touchLevel = LOW;
+    _touchMode = false;
+    _touchAsleep = false;
+    _touchSleepFailed = false;
+    _touchSleepAt = 0;
+    _touchNoFingerLED = false;
+    _touchSecurity = FPM383_SECURITY_DEFAULT;
+    FPM383_STAT(resetStats());
+    FPM383_POWER_STAT(_powerAsleep = false; resetPowerStats());
 }
 
 /**
   * @brief   串口发送函数
-  * @param   len: 发送数组长度
-  * @param   PS_Databuffer[]: 需要发送的功能协议数组，在上面已有定义
+  * @param   data: 需要发送的数据
+  * @param   len: 发送数据长度
   * @return  None
   */
-void YFROBOTFPM383::sendData(int len, uint8_t PS_Databuffer[]) {
-    _ss->write(PS_Databuffer, len);
-    while (_ss->read() >= 0)
-        ;
+void YFROBOTFPM383::sendData(const uint8_t *data, size_t len) {
+    _touchAsleep = false;       // 任意指令唤醒模组
+    FPM383_POWER_STAT(powerSleep(false));
+    _ss->write(data, len);
+}
+
+/**
+  * @brief   处理已到达的字节：流水线指令的应答计数丢弃，其他完整帧为迟到的旧应答，同样丢弃；
+  *          未接收完的帧保留在解析器中，由之后的接收继续解析
+  */
+void YFROBOTFPM383::serviceInput() {
+    while (rxAvailable()) {
+        if (feedByte(readByte()) == FPM383_RX_DONE) consumeAck();
+    }
+}
+
+/**
+  * @brief   同步指令发送前，先处理尚未到达的流水线指令应答，最长等待至 FPM383_ACK_TIMEOUT 后计为丢失。
+  *          模组按顺序应答，之后到达的只有确认码的应答一定属于新指令；否则流水线指令应答丢失时，
+  *          新指令的应答（如删除、清空的确认码）会被当作流水线指令的应答丢弃。
+  *          异步操作不在此等待，由 asyncSend() 进入 STEP_ACKS，在 poll() 中处理
+  */
+void YFROBOTFPM383::drainAcks() {
+    while (_pendingAcks > 0) {
+        serviceInput();
+        if (_pendingAcks > 0 && millis() - _ackSent >= FPM383_ACK_TIMEOUT) {
+            _acksLost += _pendingAcks;
+            _pendingAcks = 0;
+        }
+    }
 }
 
 /**
-  * @brief   串口接收函数
-  * @param   Timeout：接收超时时间
+  * @brief   刚发送的指令不等待应答，应答到达时由 consumeAck() 处理
+  */
+void YFROBOTFPM383::pipelined() {
+    if (_pendingAcks < 0xFF) _pendingAcks++;
+    _ackSent = millis();
+}
+
+/**
+  * @brief   收到完整帧时调用。模组按顺序处理指令，未读的流水线指令应答先于之后指令的应答到达，
+  *          因此有未读应答时，只有确认码的应答包为流水线指令的应答，其他帧为更早指令迟到的应答（如自动验证结果）；
+  *          超过 FPM383_ACK_TIMEOUT 才到达的流水线指令应答、等待超时的指令迟到的成功应答，
+  *          其参数长度与当前指令的成功应答不同（_expectParams）时丢弃
+  * @return  true：该帧已丢弃，不是当前指令的应答
+  */
+bool YFROBOTFPM383::consumeAck() {
+    bool bare = PS_ReceiveBuffer[6] == FPM383_PID_ACK && PS_ReceiveBuffer[7] == 0 && PS_ReceiveBuffer[8] == 3;
+    bool stale = _expectParams != 0 && PS_ReceiveBuffer[6] == FPM383_PID_ACK && PS_ReceiveBuffer[9] == 0x00 &&
+                 ((uint16_t)PS_ReceiveBuffer[7] << 8 | PS_ReceiveBuffer[8]) != _expectParams + 3;
+    if (_pendingAcks > 0 && millis() - _ackSent >= FPM383_ACK_TIMEOUT) {
+        _acksLost += _pendingAcks;              // 应答丢失，该帧按普通应答处理
+        _pendingAcks = 0;
+    }
+    if (_pendingAcks > 0) {
+        if (bare) _pendingAcks--;
+    } else if (!stale) {
+        return false;
+    }
+    _rxAny = false;                             // 超时时据此区分无应答与应答不完整
+    return true;
+}
+
+/**
+  * @brief   运行时组包发送，自动填充包头、包长度和校验和，载荷直接从调用者缓冲区发送
+  * @param   pid: 包标识，命令包 FPM383_PID_COMMAND
+  * @param   payload: 指令码及参数（命令包），或数据（数据包）
+  * @param   len: 载荷长度
+  * @param   pipeline: 不等待应答的流水线指令，无需先处理之前流水线指令的应答
   * @return  None
   */
-void YFROBOTFPM383::receiveData(uint16_t Timeout) {
-    memset(PS_ReceiveBuffer, 0xFF, sizeof(PS_ReceiveBuffer));  // 清空接收数据变量
-    uint8_t i = 0;
-    while (_ss->available() == 0 && (--Timeout)) {
-        delay(1);
+void YFROBOTFPM383::sendPacket(uint8_t pid, const uint8_t *payload, uint16_t len, bool pipeline) {
+    uint16_t length = len + 2;
+    uint8_t head[FPM383_HEADER_SIZE] = { 0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, pid, (uint8_t)(length >> 8), (uint8_t)length };
+    uint16_t sum = pid + (length >> 8) + (length & 0xFF);
+    for (uint16_t i = 0; i < len; i++) sum += payload[i];
+    uint8_t tail[2] = { (uint8_t)(sum >> 8), (uint8_t)sum };
+    _ss->listen();              // 多个软串口时，发送指令前切换为监听本模组
+    if (pid == FPM383_PID_COMMAND && !pipeline && _asyncOp == FPM383_OP_NONE) drainAcks();    // 异步操作已由 asyncSend() 处理
+    serviceInput();
+    if (pid == FPM383_PID_COMMAND) FPM383_STAT(statBegin(payload[0]));
+    FPM383_STAT(if (_statOp != NULL) { _statOp->bytesSent += len + 11; _statBytes += len + 11; });
+    FPM383_POWER_STAT(powerSent(len + 11, pid == FPM383_PID_COMMAND));
+    _ss->write(head, FPM383_HEADER_SIZE);
+    _ss->write(payload, len);
+    sendData(tail, 2);
+}
+
+/**
+  * @brief   发送存放于 flash 的固定指令包
+  * @param   packet: FPM383Packet<...>::data
+  * @param   size: FPM383Packet<...>::SIZE
+  * @param   pipeline: 不等待应答的流水线指令
+  * @return  None
+  */
+void YFROBOTFPM383::sendPacket_P(const uint8_t *packet, uint8_t size, bool pipeline) {
+    uint8_t buffer[24];
+    _ss->listen();
+    if (!pipeline && _asyncOp == FPM383_OP_NONE) drainAcks();
+    serviceInput();
+    FPM383_STAT(statBegin(pgm_read_byte(packet + FPM383_HEADER_SIZE)));
+    FPM383_STAT(if (_statOp != NULL) { _statOp->bytesSent += size; _statBytes += size; });
+    FPM383_POWER_STAT(powerSent(size, true));
+    while (size > 0) {
+        uint8_t n = size > sizeof(buffer) ? sizeof(buffer) : size;
+        memcpy_P(buffer, packet, n);
+        packet += n;
+        size -= n;
+        if (size > 0) {
+            _ss->write(buffer, n);
+        } else {
+            sendData(buffer, n);
+        }
+    }
+}
+
+/**
+  * @brief   复位帧解析器，丢弃当前未完成的帧
+  * @param   None
+  * @return  None
+  */
+void YFROBOTFPM383::resetReceive() {
+    _rxIndex = 0;
+    _rxCount = 0;
+    _rxLength = 0;
+    _rxSum = 0;
+    _rxStream = false;
+}
+
+/**
+  * @brief   增量帧解析，每收到一个字节调用一次
+  *          同步包头0xEF01，读取第7~8字节的包长度，收到最后一个字节时立即校验并返回
+  * @param   data：串口收到的字节
+  * @return  FPM383_RX_BUSY / FPM383_RX_DONE / FPM383_RX_ERROR
+  */
+uint8_t YFROBOTFPM383::feedByte(uint8_t data) {
+    if (_rxIndex == FPM383_HEADER_SIZE) return feedPayload(data);
+    if (_rxIndex == 0) {                        // 等待包头0xEF
+        if (data == 0xEF) PS_ReceiveBuffer[_rxIndex++] = data;
+        return FPM383_RX_BUSY;
+    }
+    if (_rxIndex == 1) {                        // 包头第二字节0x01
+        if (data == 0x01) {
+            PS_ReceiveBuffer[_rxIndex++] = data;
+        } else if (data != 0xEF) {
+            _rxIndex = 0;
+        }
+        return FPM383_RX_BUSY;
+    }
+
+    PS_ReceiveBuffer[_rxIndex++] = data;
+    if (_rxIndex < 7) return FPM383_RX_BUSY;    // 设备地址
+    if (_rxIndex == 7) {                        // 包标识，校验和从此开始累加
+        _rxSum = data;
+        return FPM383_RX_BUSY;
+    }
+    if (_rxIndex < FPM383_HEADER_SIZE) {
+        _rxSum += data;
+        return FPM383_RX_BUSY;
+    }
+    if (_rxIndex == FPM383_HEADER_SIZE) {       // 包长度接收完成
+        _rxSum += data;
+        _rxLength = ((uint16_t)PS_ReceiveBuffer[7] << 8) | PS_ReceiveBuffer[8];
+        // 接收数据包时，载荷由 receiveDataPackets() 直接交给接收端，不经过接收缓冲区
+        _rxStream = _sinkActive && (PS_ReceiveBuffer[6] == FPM383_PID_DATA || PS_ReceiveBuffer[6] == FPM383_PID_END);
+        // 已读取模组参数时数据包载荷不超过 _packetSize，否则按最大载荷接收
+        uint16_t max = !_rxStream ? FPM383_RECEIVE_SIZE - FPM383_HEADER_SIZE : _sysParaValid ? _packetSize + 2 : FPM383_DATA_MAX + 2;
+        if (_rxLength < 2 || _rxLength > max) {
+            return resync(_rxIndex);            // 包长度非法或超出缓冲区，重新同步
+        }
+        return FPM383_RX_BUSY;
+    }
+    return FPM383_RX_BUSY;
+}
+
+/**
+  * @brief   帧解析：包长度之后的确认码、参数及校验和
+  * @param   data：串口收到的字节
+  * @return  FPM383_RX_BUSY / FPM383_RX_DONE / FPM383_RX_ERROR
+  */
+uint8_t YFROBOTFPM383::feedPayload(uint8_t data) {
+    uint16_t payload = _rxLength - 2;
+    if (_rxCount < payload) {                   // 确认码及参数
+        _rxSum += data;
+        if (!_rxStream) PS_ReceiveBuffer[FPM383_HEADER_SIZE + _rxCount] = data;
+        _rxCount++;
+        return FPM383_RX_BUSY;
+    }
+
+    uint8_t tail = _rxStream ? FPM383_HEADER_SIZE : FPM383_HEADER_SIZE + payload;
+    PS_ReceiveBuffer[tail + _rxCount - payload] = data;
+    _rxCount++;
+    if (_rxCount < _rxLength) return FPM383_RX_BUSY;  // 校验和高字节
+
+    uint16_t sum = ((uint16_t)PS_ReceiveBuffer[tail] << 8) | PS_ReceiveBuffer[tail + 1];
+    if (sum != _rxSum) {
+        _rxError = true;
+        FPM383_STAT(if (_statOp != NULL) _statOp->checksumErrors++);
+        if (!_rxStream) return resync(tail + 2);
+        resetReceive();                         // 数据包载荷已交给接收端，无法重新解析
+        return FPM383_RX_ERROR;
+    }
+    resetReceive();
+    FPM383_POWER_STAT(_power.ops[_asyncOp].framesReceived++);
+    return FPM383_RX_DONE;
+}
+
+/**
+  * @brief   丢弃当前帧的首字节，从已接收字节中的下一个0xEF开始重新解析，
+  *          避免噪声中的伪包头吞掉紧随其后的真实应答包。待重新解析的字节由 readByte() 先于串口读出，
+  *          其中可能有多个完整帧，每帧都在之后的 feedByte() 中返回
+  * @param   count：当前帧已接收字节数
+  * @return  FPM383_RX_ERROR
+  */
+uint8_t YFROBOTFPM383::resync(uint8_t count) {
+    _rxError = true;
+    FPM383_STAT(if (_statOp != NULL) _statOp->resyncs++);
+    uint8_t k = 1;
+    while (k < count && PS_ReceiveBuffer[k] != 0xEF) k++;
+    uint8_t rest = _rxReplayEnd - _rxReplay;        // 重新解析中再次重新同步：接上尚未读出的字节
+    memmove(&PS_ReceiveBuffer[count], &PS_ReceiveBuffer[_rxReplay], rest);
+    _rxReplay = k;              // 写入位置始终小于读取位置，可原地重新解析
+    _rxReplayEnd = count + rest;
+    resetReceive();
+    return FPM383_RX_ERROR;
+}
+
+/**
+  * @brief   串口接收函数，收到一帧完整且校验正确的应答包后立即返回
+  * @param   Timeout：接收超时时间（ms）
+  * @return  true：接收成功；false：超时，接收缓冲区全部置为0xFF
+  */
+bool YFROBOTFPM383::receiveData(uint16_t Timeout) {
+    // 不复位解析器：发送前未接收完的帧（流水线指令的应答）继续解析
+    _rxError = false;
+    _rxAny = false;
+    unsigned long start = millis();
+    do {
+        while (rxAvailable()) {
+            if (feedByte(readByte()) == FPM383_RX_DONE && !consumeAck()) {
+                _lastError = FPM383_ERROR_NONE;
+                FPM383_STAT(statReply());
+                return true;
+            }
+        }
+    } while (millis() - start < Timeout);
+    memset(PS_ReceiveBuffer, 0xFF, sizeof(PS_ReceiveBuffer));
+    resetReceive();
+    receiveFailed();
+    return false;
+}
+
+/**
+  * @brief   接收一个应答包并填充到调用者的应答结构体
+  * @param   response：应答结构体
+  * @param   Timeout：接收超时时间（ms）
+  * @param   params：成功应答的参数字节数，确认码0x00但长度不符的应答为更早指令迟到的应答，丢弃；0 不检查
+  * @return  确认码或者无效值0xFF
+  */
+uint8_t YFROBOTFPM383::receiveResponse(FPM383Response &response, uint16_t Timeout, uint8_t params)
+{
+    _expectParams = params;
+    fillResponse(response, receiveData(Timeout));
+    _expectParams = 0;
+    return response.code;
+}
+
+/**
+  * @brief   从刚接收的帧中复制确认码及参数到应答结构体
+  * @param   response：应答结构体
+  * @param   received：是否收到了校验正确的帧
+  */
+void YFROBOTFPM383::fillResponse(FPM383Response &response, bool received)
+{
+    response.code = 0xFF;
+    response.error = _lastError;
+    response.length = 0;
+    memset(response.params, 0, sizeof(response.params));   // 短应答包之后的参数读取为0
+    response.id = FPM383_NO_ID;
+    response.score = 0;
+    if (!received) return;
+    if (PS_ReceiveBuffer[6] != FPM383_PID_ACK) {
+        response.error = _lastError = FPM383_ERROR_WRONG_PACKET;
+        return;
+    }
+    uint16_t length = ((uint16_t)PS_ReceiveBuffer[7] << 8) | PS_ReceiveBuffer[8];
+    response.code = PS_ReceiveBuffer[FPM383_HEADER_SIZE];
+    response.length = length - 3 > FPM383_RESPONSE_MAX ? FPM383_RESPONSE_MAX : length - 3;
+    memcpy(response.params, &PS_ReceiveBuffer[FPM383_HEADER_SIZE + 1], response.length);
+}
+
+/**
+  * @brief   读取一个字节并计入当前指令的接收字节数；重新同步后待重新解析的字节优先
+  */
+uint8_t YFROBOTFPM383::readByte() {
+    _rxAny = true;
+    if (_rxReplay < _rxReplayEnd) return PS_ReceiveBuffer[_rxReplay++];     // 已计数
+    FPM383_STAT(if (_statOp != NULL) { _statOp->bytesReceived++; _statBytes++; });
+    FPM383_POWER_STAT(_power.ops[_asyncOp].bytesReceived++);
+    return _ss->read();
+}
+
+/**
+  * @brief   是否有待解析的字节（重新同步后保留的字节或串口新到达的字节）
+  */
+bool YFROBOTFPM383::rxAvailable() {
+    return _rxReplay < _rxReplayEnd || _ss->available() > 0;
+}
+
+/**
+  * @brief   等待超时，根据本次等待中收到的字节区分错误类型
+  */
+void YFROBOTFPM383::receiveFailed() {
+    _lastError = _rxError ? FPM383_ERROR_BAD_PACKET : _rxAny ? FPM383_ERROR_TIMEOUT : FPM383_ERROR_NO_REPLY;
+    FPM383_STAT(if (_statOp != NULL) _statOp->timeouts++);
+}
+
+/**
+  * @brief   初始化，探测模组当前波特率并将主机串口切换到该波特率
+  *          依次尝试指定波特率、当前波特率及常用波特率，收到有效应答包即完成
+  *          （模组首次上电时发送的0x55握手字节会被帧解析器忽略，无需等待）
+  *          找到模组后读取一次基本参数（指纹库容量、安全等级、数据包大小）并缓存
+  * @param   baud：优先尝试的波特率，0 表示从当前波特率开始
+  * @return  true：找到模组；false：所有波特率均无应答，主机恢复为原波特率
+  */
+bool YFROBOTFPM383::begin(uint32_t baud)
+{
+    static const uint32_t rates[] = { FPM383_BAUD_DEFAULT, 115200, 9600, 19200, 38400, 76800 };
+    uint32_t original = _baud;
+    bool found = false;
+    if (baud != 0) {
+        _ss->setBaudRate(baud);
+        _baud = baud;
+        found = probe();
+    }
+    if (!found) {
+        _ss->setBaudRate(original);
+        _baud = original;
+        found = probe();
     }
-    while (_ss->available() > 0) {
-        delay(1);
-        PS_ReceiveBuffer[i++] = _ss->read();
-        if (i > 50) break;  // 超出50字节数据不接收
+    for (uint8_t i = 0; !found && i < sizeof(rates) / sizeof(rates[0]); i++) {
+        if (rates[i] == original || rates[i] == baud) continue;
+        _ss->setBaudRate(rates[i]);
+        _baud = rates[i];
+        found = probe();
     }
+    if (!found) {
+        _ss->setBaudRate(original);
+        _baud = original;
+        return false;
+    }
+    readSysPara();      // 读取失败时保留默认参数
+    return true;
 }
 
 /**
-  * @brief   初始化，接收到模组数据0x55则表示初始化完成 (无用，模块只有在首次上电时会发送0x55，实际使用延时等待模组初始化即可)
+  * @brief   以当前波特率发送读有效模板个数指令，检查能否收到校验正确的应答包
   * @param   None
   * @return  bool
   */
-bool YFROBOTFPM383::begin()
+bool YFROBOTFPM383::probe()
 {
-    receiveData(1000);
-    if(PS_ReceiveBuffer[0] == 0x55){
-        return true;
-    }
+    SEND_PACKET(PS_ValidTempleteNum);
+    return receiveData(FPM383_PROBE_TIMEOUT) && PS_ReceiveBuffer[6] == 0x07;
+}
+
+/**
+  * @brief   写模组系统寄存器
+  * @param   reg：寄存器序号
+  * @param   value：寄存器内容
+  * @return  应答包第9位确认码或者无效值0xFF
+  */
+uint8_t YFROBOTFPM383::writeReg(uint8_t reg, uint8_t value)
+{
+    uint8_t cmd[3] = { PS_WRITE_REG, reg, value };
+    return command(cmd, sizeof(cmd), 2000);
+}
+
+/**
+  * @brief   修改模组波特率，并将主机串口切换到相同波特率后验证通信
+  *          模组掉电后保持新波特率，下次可由 begin() 自动探测
+  * @param   baud：9600的整数倍，9600~115200
+  * @return  true：切换成功；false：模组拒绝或新波特率下无应答（主机已恢复原波特率）
+  */
+bool YFROBOTFPM383::setBaudRate(uint32_t baud)
+{
+    if (baud % FPM383_BAUD_UNIT != 0 || baud / FPM383_BAUD_UNIT < 1 || baud / FPM383_BAUD_UNIT > 12) return false;
+    uint32_t original = _baud;
+    if (writeReg(REG_BAUD, baud / FPM383_BAUD_UNIT) != 0x00) return false;
+    _ss->setBaudRate(baud);
+    _baud = baud;
+    if (probe()) return true;
+    _ss->setBaudRate(original);
+    _baud = original;
+    return false;
+}
+
+/**
+  * @brief   当前主机与模组通信波特率
+  */
+uint32_t YFROBOTFPM383::baudRate()
+{
+    return _baud;
+}
+
+/**
+  * @brief   读取模组基本参数并缓存指纹库容量、安全等级、数据包大小，begin() 时自动调用
+  *          波特率由 begin() 探测得到，不从参数表更新
+  * @param   None
+  * @return  true：读取成功；false：保留之前的参数
+  */
+bool YFROBOTFPM383::readSysPara()
+{
+    FPM383Response response;
+    return readSysPara(response) == 0x00;
+}
+
+uint8_t YFROBOTFPM383::readSysPara(FPM383Response &response)
+{
+    SEND_PACKET(PS_ReadSysPara);
+    if (receiveResponse(response, 1000, 16) != 0x00) return response.code;
+    uint16_t capacity = response.param16(SYS_PARA_CAPACITY);
+    uint16_t security = response.param16(SYS_PARA_SECURITY);
+    uint16_t size = response.param16(SYS_PARA_PACKET_SIZE);
+    if (capacity > 0) _capacity = capacity;
+    if (security >= 1 && security <= 5) _securityLevel = security;
+    if (size <= 3) _packetSize = FPM383_PACKET_SIZE_MIN << size;
+    _sysParaValid = true;
+    return response.code;
+}
+
+/**
+  * @brief   指纹库容量，有效ID为 0 ~ capacity()-1；未读取模组参数时为 FPM383_CAPACITY_DEFAULT
+  */
+uint16_t YFROBOTFPM383::capacity()
+{
+    return _capacity;
+}
+
+/**
+  * @brief   模组安全等级（1~5）；未读取模组参数时为 FPM383_SECURITY_DEFAULT
+  */
+uint8_t YFROBOTFPM383::securityLevel()
+{
+    return _securityLevel;
+}
+
+/**
+  * @brief   多包传输（模板、图像）的数据包载荷大小（字节）
+  */
+uint16_t YFROBOTFPM383::packetSize()
+{
+    return _packetSize;
+}
+
+/**
+  * @brief   修改模组数据包大小：载荷越大，多包传输的包头、校验和越少。模组掉电后保持新设置
+  * @param   size：32、64、128 或 256 字节
+  * @return  true：修改成功；false：参数错误或模组拒绝
+  */
+bool YFROBOTFPM383::setPacketSize(uint16_t size)
+{
+    uint8_t n = 0;
+    while (n < 4 && (FPM383_PACKET_SIZE_MIN << n) != size) n++;
+    if (n == 4) return false;
+    if (writeReg(REG_PACKET_SIZE, n) != 0x00) return false;
+    _packetSize = size;
+    return true;
+}
+
+/**
+  * @brief   检查ID范围是否在指纹库容量之内，超出时不发送指令，确认码0xFF，错误原因 FPM383_ERROR_RANGE。
+  *          未读取模组参数（未调用 begin()）时容量未知，不检查，由模组判断
+  * @param   start：起始ID
+  * @param   count：ID个数
+  * @param   response：应答结构体
+  * @return  true：在范围之内
+  */
+bool YFROBOTFPM383::checkRange(uint16_t start, uint32_t count, FPM383Response &response)
+{
+    if (count > 0 && (!_sysParaValid || start + count <= _capacity)) return true;
+    _lastError = FPM383_ERROR_RANGE;
+    fillResponse(response, false);
     return false;
 }
 
+/**
+  * @brief   ID是否超出已读取的指纹库容量，超出时 lastError() 为 FPM383_ERROR_RANGE；未读取模组参数时不检查
+  */
+bool YFROBOTFPM383::outOfRange(uint16_t id)
+{
+    if (!_sysParaValid || id < _capacity) return false;
+    _lastError = FPM383_ERROR_RANGE;
+    return true;
+}
+
 /**
   * @brief   等待初始化，并获取模组型号，建议在setup中使用
   * @param   None
@@ -89,30 +776,30 @@ bool YFROBOTFPM383::begin()
   */
 String YFROBOTFPM383::getChipSN()
 {
-    delay(200);  //等待指纹识别模块初始化完成，不可去掉，此期间不能响应命令
-    sendData(13, PS_GetChipSN);
-    receiveData(1000);
-    if( PS_ReceiveBuffer[6] == 0x07 && PS_ReceiveBuffer[9] == 0x00 ) {
-        uint8_t CSN[10];
-        for(int i = 0; i < 9; i++){
-            CSN[i] =  PS_ReceiveBuffer[i+10];
-        }
-        controlLED(PS_OFFLEDBuffer);    // 全灭
-        delay(100); // 重要
-        return HexToString(CSN, 9);
-    }
-    return "";
+    char sn[FPM383_CHIP_SN_LENGTH + 1];
+    return getChipSN(sn, sizeof(sn)) ? String(sn) : String("");
 }
 
-String YFROBOTFPM383::HexToString(uint8_t* data, uint8_t length) {
-    if (!data || !length) { return ""; }
-    String result = "";
-    for (uint8_t i = 0; i < length; i++) {
-        // uint8_t my_hex = 0x50;
-        // String my_char = String((char)my_hex) //output "P"
-        result += String((char)data[i]) ;
-    }
-    return result;
+/**
+  * @brief   等待初始化，并获取模组序列号，不分配内存
+  * @param   sn：序列号缓冲区，以'\0'结尾，最多 FPM383_CHIP_SN_LENGTH 个字符
+  * @param   size：缓冲区大小
+  * @return  true：获取成功；false：无应答，sn 为空字符串
+  */
+bool YFROBOTFPM383::getChipSN(char *sn, size_t size)
+{
+    if (sn == NULL || size == 0) return false;
+    sn[0] = '\0';
+    delay(200);  //等待指纹识别模块初始化完成，不可去掉，此期间不能响应命令
+    FPM383Response response;
+    SEND_PACKET(PS_GetChipSN);
+    if (receiveResponse(response, 1000, 32) != 0x00) return false;  // 应答参数为32字节序列号
+    size_t n = response.length < FPM383_CHIP_SN_LENGTH ? response.length : FPM383_CHIP_SN_LENGTH;
+    if (n > size - 1) n = size - 1;
+    memcpy(sn, response.params, n);
+    sn[n] = '\0';
+    SEND_PIPELINED(PS_OFFLED);    // 全灭
+    return true;
 }
 
 /**
@@ -122,17 +809,24 @@ String YFROBOTFPM383::HexToString(uint8_t* data, uint8_t length) {
   */
 void YFROBOTFPM383::sleep()
 {
-    sendData(12, PS_SleepBuffer);
+    SEND_PIPELINED(PS_Sleep);
+    FPM383_POWER_STAT(powerSleep(true));
 }
 
 /**
   * @brief   模块LED灯控制函数
-  * @param   PS_ControlLEDBuffer[]：需要设置颜色的协议，一般定义在上面
+  * @param   PS_ControlLEDBuffer[]：完整的16字节LED控制指令包（含包头及校验和）
   * @return  None
   */
 void YFROBOTFPM383::controlLED( uint8_t PS_ControlLEDBuffer[] )
 {
-    sendData(16, PS_ControlLEDBuffer);
+    _ss->listen();
+    serviceInput();
+    FPM383_STAT(statBegin(PS_ControlLEDBuffer[FPM383_HEADER_SIZE]));
+    FPM383_STAT(if (_statOp != NULL) { _statOp->bytesSent += 16; _statBytes += 16; });
+    FPM383_POWER_STAT(powerSent(16, true));
+    sendData(PS_ControlLEDBuffer, 16);
+    pipelined();
 }
 
 /**
@@ -148,21 +842,9 @@ void YFROBOTFPM383::controlLED( uint8_t PS_ControlLEDBuffer[] )
   */
 void YFROBOTFPM383::controlLEDC( uint8_t fun, uint8_t start, uint8_t end, uint8_t cycle )
 {
-    uint16_t checksum = 0x44;
-    PS_CustomLEDBuffer[10] = (fun);
-    checksum += fun;
-    PS_CustomLEDBuffer[11] = (start);
-    checksum += start;
-    PS_CustomLEDBuffer[12] = (end);
-    checksum += end;
-    PS_CustomLEDBuffer[13] = (cycle);
-    checksum += cycle;
-    PS_CustomLEDBuffer[14] = checksum >> 8;
-    PS_CustomLEDBuffer[15] = checksum;
-    // for(int i = 10;i<=15;i++){
-    //     Serial.println(PS_CustomLEDBuffer[i]);
-    // }
-    sendData(16, PS_CustomLEDBuffer);
+    uint8_t cmd[5] = { PS_CONTROL_LED, fun, start, end, cycle };
+    sendPacket(FPM383_PID_COMMAND, cmd, sizeof(cmd), true);
+    pipelined();
 }
 
 /**
@@ -172,9 +854,20 @@ void YFROBOTFPM383::controlLEDC( uint8_t fun, uint8_t start, uint8_t end, uint8_
   */
 uint8_t YFROBOTFPM383::cancel()
 {
-    sendData(12, PS_CancelBuffer);
-    receiveData(2000);
-    return PS_ReceiveBuffer[6] == 0x07 ? PS_ReceiveBuffer[9] : 0xFF;
+    FPM383Response response;
+    return cancel(response);
+}
+
+uint8_t YFROBOTFPM383::cancel(FPM383Response &response)
+{
+    SEND_PACKET(PS_Cancel);
+    // 跳过自动注册/自动验证在取消前已发出的状态包，取消应答只有确认码（包长度3）
+    while (receiveData(2000)) {
+        fillResponse(response, true);
+        if (response.error == FPM383_ERROR_NONE && response.length == 0) return response.code;
+    }
+    fillResponse(response, false);
+    return 0xFF;
 }
 
 /**
@@ -184,9 +877,14 @@ uint8_t YFROBOTFPM383::cancel()
   */
 uint8_t YFROBOTFPM383::getImage()
 {
-    sendData(12, PS_GetImageBuffer);
-    receiveData(2000);
-    return PS_ReceiveBuffer[6] == 0x07 ? PS_ReceiveBuffer[9] : 0xFF;
+    FPM383Response response;
+    return getImage(response);
+}
+
+uint8_t YFROBOTFPM383::getImage(FPM383Response &response)
+{
+    SEND_PACKET(PS_GetImage);
+    return receiveResponse(response, 2000);
 }
 
 /**
@@ -196,9 +894,14 @@ uint8_t YFROBOTFPM383::getImage()
   */
 uint8_t YFROBOTFPM383::getChar()
 {
-    sendData(13, PS_GetCharBuffer);
-    receiveData(2000);
-    return PS_ReceiveBuffer[6] == 0x07 ? PS_ReceiveBuffer[9] : 0xFF;
+    FPM383Response response;
+    return getChar(response);
+}
+
+uint8_t YFROBOTFPM383::getChar(FPM383Response &response)
+{
+    SEND_PACKET(PS_GetChar);
+    return receiveResponse(response, 2000);
 }
 
 
@@ -209,145 +912,1439 @@ uint8_t YFROBOTFPM383::getChar()
   */
 uint8_t YFROBOTFPM383::searchMB()
 {
-    sendData(17, PS_SearchMBBuffer);
-    receiveData(2000);
-    return PS_ReceiveBuffer[6] == 0x07 ? PS_ReceiveBuffer[9] : 0xFF;
+    FPM383Response response;
+    return searchMB(response);
 }
 
 /**
-  * @brief   删除指定指纹模板函数
-  * @param   PageID：需要删除的指纹ID号，取值0 - 49（FPM383F）
-  * @return  应答包第9位确认码或者无效值0xFF
+  * @brief   搜索指纹模板函数，搜索到时 response.id、response.score 为指纹ID号及得分
+  * @param   response：应答结构体
+  * @return  确认码或者无效值0xFF
   */
-uint8_t YFROBOTFPM383::deleteID(uint16_t PageID)
+uint8_t YFROBOTFPM383::searchMB(FPM383Response &response)
 {
-    PS_DeleteBuffer[10] = (PageID>>8);
-    PS_DeleteBuffer[11] = (PageID);
-    PS_DeleteBuffer[14] = (0x15+PS_DeleteBuffer[10]+PS_DeleteBuffer[11])>>8;
-    PS_DeleteBuffer[15] = (0x15+PS_DeleteBuffer[10]+PS_DeleteBuffer[11]);
-    sendData(16, PS_DeleteBuffer);
-    receiveData(2000);
-    return PS_ReceiveBuffer[6] == 0x07 ? PS_ReceiveBuffer[9] : 0xFF;
+    return searchMB(0, FPM383_SEARCH_ALL, response);
 }
 
 /**
-  * @brief   清空指纹模板函数 
-  * @param   None
-  * @return  应答包第9位确认码或者无效值0xFF
+  * @brief   只在指纹库的一段ID中搜索，库按门禁、班次等分组时缩短搜索时间，并且不会误识别为其他分组的指纹
+  * @param   start：起始ID
+  * @param   count：ID个数，FPM383_SEARCH_ALL 为起始ID之后全部；超出指纹库容量的部分不搜索
+  * @param   PageID：返回搜索到的指纹ID号，可为NULL
+  * @param   score：返回得分，可为NULL
+  * @return  应答包第9位确认码（0x09 该段中未搜索到）或者无效值0xFF（起始ID超出容量时不发送指令）
   */
-uint8_t YFROBOTFPM383::empty()
+uint8_t YFROBOTFPM383::searchMB(uint16_t start, uint16_t count, uint16_t *PageID, uint16_t *score)
 {
-    sendData(12, PS_EmptyBuffer);
-    receiveData(2000);
-    return PS_ReceiveBuffer[6] == 0x07 ? PS_ReceiveBuffer[9] : 0xFF;
+    FPM383Response response;
+    if (searchMB(start, count, response) == 0x00) {
+        if (PageID != NULL) *PageID = response.id;
+        if (score != NULL) *score = response.score;
+    }
+    return response.code;
 }
 
+uint8_t YFROBOTFPM383::searchMB(uint16_t start, uint16_t count, FPM383Response &response)
+{
+    count = searchCount(start, count);
+    if (!checkRange(start, count, response)) return response.code;
+    sendSearch(start, count);
+    if (receiveResponse(response, 2000, 4) == 0x00) {
+        response.id = response.param16(0);
+        response.score = response.param16(2);
+    }
+    return response.code;
+}
 
 /**
-  * @brief   自动注册指纹模板函数, 默认采集4次
-  * @param   PageID：注册指纹的ID号，取值0 - 49（FPM383F）
-  * @param   entriesCount：录入（拼接）次数，取值1~12，推荐4~6
+  * @brief   搜索指纹模板函数，返回搜索到的ID号及得分
+  * @param   PageID：返回搜索到的指纹ID号，可为NULL
+  * @param   score：返回得分，可为NULL
   * @return  应答包第9位确认码或者无效值0xFF
   */
-uint8_t * YFROBOTFPM383::autoEnroll(uint16_t PageID, uint8_t entriesCount)
+uint8_t YFROBOTFPM383::searchMB(uint16_t *PageID, uint16_t *score)
 {
-    static uint8_t backData[3] = {0xFF,0xFF,0xFF};
-    uint8_t eC = entriesCount > 12 ? 12 : entriesCount;
-    PS_AutoEnrollBuffer[10] = (PageID>>8);
-    PS_AutoEnrollBuffer[11] = (PageID);
-    PS_AutoEnrollBuffer[12] = (eC);
-    PS_AutoEnrollBuffer[15] = (PS_AutoEnrollBuffer_Check+PS_AutoEnrollBuffer[10]+PS_AutoEnrollBuffer[11]+PS_AutoEnrollBuffer[12])>>8;
-    PS_AutoEnrollBuffer[16] = (PS_AutoEnrollBuffer_Check+PS_AutoEnrollBuffer[10]+PS_AutoEnrollBuffer[11]+PS_AutoEnrollBuffer[12]);
-    sendData(17, PS_AutoEnrollBuffer);
-    receiveData(10000);
-    // return PS_ReceiveBuffer[6] == 0x07 ? PS_ReceiveBuffer[9] : 0xFF;
-    if(PS_ReceiveBuffer[6] == 0x07){
-        backData[0] = PS_ReceiveBuffer[9]; 
-        backData[1] = PS_ReceiveBuffer[10];
-        backData[2] = PS_ReceiveBuffer[11];
+    FPM383Response response;
+    if (searchMB(response) == 0x00) {
+        if (PageID != NULL) *PageID = response.id;
+        if (score != NULL) *score = response.score;
     }
-    return backData;
+    return response.code;
 }
 
 /**
-  * @brief   二次封装自动注册指纹函数，实现注册成功闪烁两次绿灯，失败闪烁两次红灯
-  * @param   PageID：注册指纹的ID号，取值0 - 49（FPM383F）
-  * @return  应答包第9位确认码或者无效值0xFF
+  * @brief   精确比对特征缓冲区1与缓冲区2（1:1）
+  * @param   score：返回得分，可为NULL
+  * @return  应答包第9位确认码（0x00 匹配，0x08 不匹配）或者无效值0xFF
   */
-uint8_t YFROBOTFPM383::enroll(uint16_t PageID, uint8_t entriesCount)
-{   
-    controlLED(PS_BlueLEDBuffer); // 点亮蓝灯，注册开始
-    delay(10);
-    uint8_t *confirmationCode = autoEnroll(PageID, entriesCount);
-    // Serial.print(confirmationCode[0]);
-    // Serial.print(" ");
-    // Serial.print(confirmationCode[1]);
-    // Serial.print(" ");
-    // Serial.println(confirmationCode[2]);
-    if(confirmationCode[0] == 0x00 &&confirmationCode[1] == 0x06 &&confirmationCode[2] == 0xf2  ){
-        controlLED(PS_GreenLEDBuffer); // 绿灯闪烁，注册成功
-        Serial.println("ok");
-        return 0x00;
-    }else if(confirmationCode[0] == 0x22 &&confirmationCode[1] == 0x00 &&confirmationCode[2] == 0x00  ){
-        controlLED(PS_RedLEDLOOPBuffer);
-        return 0x01; // 该ID已注册指纹循环闪烁红灯
-    } else {
-        controlLED(PS_OFFLEDBuffer);    // 全灭
-        return 0xff;
-    }
+uint8_t YFROBOTFPM383::match(uint16_t *score)
+{
+    FPM383Response response;
+    if (match(response) == 0x00 && score != NULL) *score = response.score;
+    return response.code;
 }
 
 /**
-  * @brief   分步式命令搜索指纹函数
-  * @param   None
-  * @return  应答包第9位确认码或者无效值0xFF
+  * @brief   精确比对特征缓冲区1与缓冲区2（1:1），匹配时 response.score 为得分
+  * @param   response：应答结构体
+  * @return  确认码（0x00 匹配，0x08 不匹配）或者无效值0xFF
   */
-uint8_t YFROBOTFPM383::identify(bool NoFingerLED)
-{
-    if(getImage() == 0x00) {
-        if(getChar() == 0x00) {
-            uint8_t sMB = searchMB();
-            // Serial.println(sMB);
-            if(sMB == 0x00) { // 搜索到认证手指时，解析返回数据
-                // uint8_t PackageID = PS_ReceiveBuffer[6];
-                if(PS_ReceiveBuffer[6] == 0x07) {
-                    // static uint8_t confirmationCode = PS_ReceiveBuffer[9];
-                    if(PS_ReceiveBuffer[9] == 0x00) {     // 返回数据校验正确，则识别正常，返回指纹ID并闪烁绿灯两次
-                        controlLED(PS_GreenLEDBuffer);
-                        // int SearchID = (int)((PS_ReceiveBuffer[10] << 8) + PS_ReceiveBuffer[11]);
-                        int SearchID = (int)(PS_ReceiveBuffer[11]);
-                        return SearchID; // 此模组最大支持49个指纹库，所以直接返回第11位码即可；ID码有2字节
-                    }
-                }
-            } else if (sMB == 0x17){
-                // controlLED(PS_BlueLEDBuffer);
-                // return 0x17;
-            } else { // 搜索到未认证手指时，闪烁红灯两次
-                controlLED(PS_RedLEDBuffer);
-                return 0xFE;    // 搜索到未认证手指时，默认返回 0xFE
-            }
-        }
-    } else if(getImage() == 0x02) { // 无手指时，NoFingerLED == true 闪烁红绿色灯一次
-        if ( NoFingerLED )
-        {
-            controlLED(PS_RGLEDBlinkBuffer);
-        }
-    }
+uint8_t YFROBOTFPM383::match(FPM383Response &response)
+{
+    SEND_PACKET(PS_Match);
+    if (receiveResponse(response, 2000, 2) == 0x00) response.score = response.param16(0);
+    return response.code;
+}
 
-    return 0xFF;
+/**
+  * @brief   删除指定指纹模板函数
+  * @param   PageID：需要删除的指纹ID号，取值0 ~ capacity()-1（FPM383F 为0 - 49）
+  * @return  应答包第9位确认码或者无效值0xFF
+  */
+uint8_t YFROBOTFPM383::deleteID(uint16_t PageID)
+{
+    FPM383Response response;
+    return deleteID(PageID, response);
 }
 
+uint8_t YFROBOTFPM383::deleteID(uint16_t PageID, FPM383Response &response)
+{
+    return deleteRange(PageID, 1, response);
+}
 
 /**
-  * @brief   读取有效模板个数，查询当前已注册指纹数量
-  * @param   None
-  * @return  应答包第11位有效数量或者无效值0xFF
+  * @brief   一条指令删除从 start 开始的 count 个指纹模板，代替逐个 deleteID() 往返
+  * @param   start：起始ID
+  * @param   count：删除个数
+  * @return  应答包第9位确认码或者无效值0xFF
+  */
+uint8_t YFROBOTFPM383::deleteRange(uint16_t start, uint16_t count)
+{
+    FPM383Response response;
+    return deleteRange(start, count, response);
+}
+
+uint8_t YFROBOTFPM383::deleteRange(uint16_t start, uint16_t count, FPM383Response &response)
+{
+    if (!checkRange(start, count, response)) return response.code;
+    uint8_t cmd[5] = { PS_DELETE, (uint8_t)(start >> 8), (uint8_t)start, (uint8_t)(count >> 8), (uint8_t)count };
+    if (request(cmd, sizeof(cmd), response) == 0x00) {
+        for (uint32_t id = start; id < (uint32_t)start + count && id < FPM383_MAX_IDS; id++) markIndex(id, false);
+    }
+    return response.code;
+}
+
+/**
+  * @brief   清空指纹模板函数 
+  * @param   None
+  * @return  应答包第9位确认码或者无效值0xFF
+  */
+uint8_t YFROBOTFPM383::empty()
+{
+    FPM383Response response;
+    return empty(response);
+}
+
+uint8_t YFROBOTFPM383::empty(FPM383Response &response)
+{
+    SEND_PACKET(PS_Empty);
+    if (receiveResponse(response, 2000) == 0x00) memset(_index, 0, sizeof(_index));
+    return response.code;
+}
+
+
+/**
+  * @brief   按 _enrollID、_enrollCount 组包发送自动注册指令
+  * @param   None
+  * @return  None
+  */
+void YFROBOTFPM383::sendAutoEnroll()
+{
+    _enrollStatus = _progress != NULL;
+    uint16_t flags = _enrollStatus ? PS_AUTO_ENROLL_FLAGS & ~PS_AUTO_ENROLL_STATUS : PS_AUTO_ENROLL_FLAGS;
+    uint8_t cmd[6] = { PS_AUTO_ENROLL, (uint8_t)(_enrollID >> 8), (uint8_t)_enrollID, _enrollCount,
+                       (uint8_t)(flags >> 8), (uint8_t)flags };
+    sendPacket(FPM383_PID_COMMAND, cmd, sizeof(cmd));
+}
+
+/**
+  * @brief   将搜索范围限制在指纹库容量之内；未读取模组参数时容量未知，不截断
+  * @param   start：起始ID
+  * @param   count：ID个数，FPM383_SEARCH_ALL 为起始ID之后全部
+  * @return  实际搜索的ID个数，起始ID超出容量时为0
+  */
+uint16_t YFROBOTFPM383::searchCount(uint16_t start, uint16_t count)
+{
+    if (!_sysParaValid) return count;
+    if (start >= _capacity) return 0;
+    return (uint32_t)start + count > _capacity ? _capacity - start : count;
+}
+
+/**
+  * @brief   发送搜索指令，搜索整个指纹库时使用固定指令包
+  * @param   start：起始ID
+  * @param   count：ID个数
+  */
+void YFROBOTFPM383::sendSearch(uint16_t start, uint16_t count)
+{
+    if (start == 0 && (count == FPM383_SEARCH_ALL || (_sysParaValid && count >= _capacity))) {
+        SEND_PACKET(PS_SearchMB);
+        return;
+    }
+    uint8_t cmd[6] = { PS_SEARCH, 0x01, (uint8_t)(start >> 8), (uint8_t)start, (uint8_t)(count >> 8), (uint8_t)count };
+    sendPacket(FPM383_PID_COMMAND, cmd, sizeof(cmd));
+}
+
+/**
+  * @brief   自动注册指纹模板函数, 默认采集4次
+  * @param   PageID：注册指纹的ID号，取值0 ~ capacity()-1（FPM383F 为0 - 49）
+  * @param   entriesCount：录入（拼接）次数，取值1~12，推荐4~6
+  * @return  应答包确认码、参数1、参数2，存放于本对象内，下次调用时覆盖；超时为0xFF
+  *          设置了进度回调时，每个关键步骤的状态包都会交给回调，回调返回 false 时发送取消指令并返回
+  */
+uint8_t * YFROBOTFPM383::autoEnroll(uint16_t PageID, uint8_t entriesCount)
+{
+    FPM383Response response;
+    memset(_enrollReply, 0xFF, sizeof(_enrollReply));
+    if (autoEnroll(PageID, entriesCount, response) != 0xFF && response.code != FPM383_RESULT_CANCELLED) {
+        _enrollReply[0] = response.code;
+        _enrollReply[1] = response.length > 0 ? response.params[0] : 0xFF;
+        _enrollReply[2] = response.length > 1 ? response.params[1] : 0xFF;
+    }
+    return _enrollReply;
+}
+
+/**
+  * @brief   自动注册指纹模板函数，最终应答写入 response：参数1（步骤）、参数2 为 params[0]、params[1]
+  * @param   PageID、entriesCount：同 autoEnroll()
+  * @param   response：应答结构体；进度回调取消时确认码为 FPM383_RESULT_CANCELLED
+  * @return  确认码或者无效值0xFF
+  */
+uint8_t YFROBOTFPM383::autoEnroll(uint16_t PageID, uint8_t entriesCount, FPM383Response &response)
+{
+    if (!checkRange(PageID, 1, response)) return response.code;
+    _enrollID = PageID;
+    _enrollCount = entriesCount > 12 ? 12 : entriesCount;
+    sendAutoEnroll();
+    // 开启状态返回时，每个步骤的等待时间单独计算
+    _expectParams = 2;                          // 步骤 采集次数
+    while (receiveData(10000)) {
+        fillResponse(response, true);
+        if (response.error != FPM383_ERROR_NONE) continue;
+        uint8_t code = response.code;
+        bool final = enrollFinal(code, response.params[0]);
+        bool proceed = _progress == NULL || _progress(this, response.params[0], response.params[1], code);
+        if (final) {
+            _expectParams = 0;
+            if (code == 0x00 || code == 0x22) markIndex(PageID, true);
+            return code;
+        }
+        if (!proceed) {
+            _expectParams = 0;
+            cancel();
+            fillResponse(response, false);
+            response.code = FPM383_RESULT_CANCELLED;
+            response.error = FPM383_ERROR_NONE;
+            return response.code;
+        }
+    }
+    _expectParams = 0;
+    fillResponse(response, false);
+    return 0xFF;
+}
+
+/**
+  * @brief   判断自动注册应答包是否为最终结果
+  *          开启状态返回时，采集步骤（获取图像、生成特征）失败模组会重新采集，不是最终结果；采图超时0x26除外
+  * @param   code：确认码
+  * @param   param1：步骤
+  * @return  true：注册已结束
+  */
+bool YFROBOTFPM383::enrollFinal(uint8_t code, uint8_t param1)
+{
+    if (!_enrollStatus) return true;
+    if (code == 0x00) return param1 == FPM383_ENROLL_STORE;
+    return !((param1 == FPM383_ENROLL_IMAGE || param1 == FPM383_ENROLL_CHAR) && code != 0x26);
+}
+
+/**
+  * @brief   解析自动注册应答包，注册成功闪烁两次绿灯，该ID已注册循环闪烁红灯
+  * @param   code：确认码
+  * @param   param1：参数1（当前步骤）
+  * @param   param2：参数2（当前录入次数或步骤标识）
+  * @return  0x00：注册成功；0x01：该ID已注册；0xFF：失败
+  */
+uint8_t YFROBOTFPM383::enrollResult(uint8_t code, uint8_t param1, uint8_t param2)
+{
+    if (code == 0x00 || code == 0x22) markIndex(_enrollID, true);
+    if(code == 0x00 && param1 == 0x06 && param2 == 0xf2){
+        SEND_PIPELINED(PS_GreenLED); // 绿灯闪烁，注册成功
+        return 0x00;
+    }else if(code == 0x22 && param1 == 0x00 && param2 == 0x00){
+        SEND_PIPELINED(PS_RedLEDLOOP);
+        return 0x01; // 该ID已注册指纹循环闪烁红灯
+    } else {
+        SEND_PIPELINED(PS_OFFLED);    // 全灭
+        return 0xff;
+    }
+}
+
+/**
+  * @brief   二次封装自动注册指纹函数，实现注册成功闪烁两次绿灯，失败闪烁两次红灯
+  * @param   PageID：注册指纹的ID号，取值0 ~ capacity()-1（FPM383F 为0 - 49）
+  * @return  0x00 成功；0x01 该ID已注册；进度回调取消返回 FPM383_RESULT_CANCELLED；其他失败0xFF
+  */
+uint8_t YFROBOTFPM383::enroll(uint16_t PageID, uint8_t entriesCount)
+{   
+    if (!beginEnroll(PageID, entriesCount)) return 0xFF;
+    while (poll() == FPM383_BUSY)
+        ;
+    return _asyncResult;
+}
+
+/**
+  * @brief   分步式命令搜索指纹函数
+  * @param   NoFingerLED：无手指时是否闪烁红绿色灯一次
+  * @param   start：搜索的起始ID，默认0
+  * @param   count：搜索的ID个数，默认 FPM383_SEARCH_ALL 搜索整个指纹库
+  * @return  指纹ID；该段中未搜索到返回0xFE；无手指或失败返回0xFF
+  */
+uint8_t YFROBOTFPM383::identify(bool NoFingerLED, uint16_t start, uint16_t count)
+{
+    if (!beginIdentify(NoFingerLED, start, count)) return 0xFF;
+    while (poll() == FPM383_BUSY)
+        ;
+    return _asyncResult;
+}
+
+/**
+  * @brief   发送运行时组包的命令并等待应答包
+  * @param   cmd：指令码及参数
+  * @param   len：cmd 长度
+  * @param   Timeout：接收超时时间（ms）
+  * @return  应答包第9位确认码或者无效值0xFF
+  */
+uint8_t YFROBOTFPM383::command(const uint8_t *cmd, uint8_t len, uint16_t Timeout)
+{
+    FPM383Response response;
+    return request(cmd, len, response, Timeout);
+}
+
+/**
+  * @brief   发送任意指令并将应答包写入调用者的应答结构体
+  * @param   cmd：指令码及参数
+  * @param   len：cmd 长度
+  * @param   response：应答结构体
+  * @param   Timeout：接收超时时间（ms）
+  * @return  确认码或者无效值0xFF
+  */
+uint8_t YFROBOTFPM383::request(const uint8_t *cmd, uint8_t len, FPM383Response &response, uint16_t Timeout)
+{
+    sendPacket(FPM383_PID_COMMAND, cmd, len);
+    return receiveResponse(response, Timeout);
+}
+
+/**
+  * @brief   接收模组连续发送的数据包直到结束包，载荷直接写入调用者缓冲区、环形缓冲区或逐块交给回调，
+  *          不经过接收缓冲区。缓冲区不足或回调中止时继续接收剩余数据包以保持同步；
+  *          环形缓冲区已满时暂停读取串口，等待读取方腾出空间
+  * @param   sink：接收端
+  * @param   Timeout：每个数据包的接收超时时间（ms）
+  * @return  true：全部数据包接收且校验正确
+  */
+bool YFROBOTFPM383::receiveDataPackets(FPM383DataSink &sink, uint16_t Timeout)
+{
+    bool ok = true;
+    sink.length = 0;
+    resetReceive();
+    _sinkActive = true;
+    _rxError = false;
+    _rxAny = false;
+    unsigned long begin = micros();
+    unsigned long start = millis();
+    while (millis() - start < Timeout) {
+        if (!rxAvailable()) continue;
+        if (_rxStream && _rxCount < _rxLength - 2) {    // 数据包载荷，批量读取
+            uint16_t n = _rxLength - 2 - _rxCount;
+            uint16_t avail = _ss->available();
+            if (n > avail) n = avail;
+            if (sink.ring != NULL && ok) {
+                uint32_t space = sink.ring->space();
+                if (space == 0) continue;               // 等待读取方
+                if (n > space) n = space;
+            }
+            if (sink.buffer == NULL && sink.ring == NULL && n > FPM383_CHUNK_SIZE) n = FPM383_CHUNK_SIZE;
+            FPM383_STAT(if (_statOp != NULL) { _statOp->bytesReceived += n; _statBytes += n; });
+            FPM383_POWER_STAT(_power.ops[_asyncOp].bytesReceived += n);
+            if (sink.ring != NULL) {
+                for (uint16_t i = 0; i < n; i++) {
+                    uint8_t b = _ss->read();
+                    _rxSum += b;
+                    if (ok) sink.ring->write(b);
+                }
+                sink.length += n;
+            } else if (sink.buffer != NULL) {
+                for (uint16_t i = 0; i < n; i++) {
+                    uint8_t b = _ss->read();
+                    _rxSum += b;
+                    if (sink.length < sink.capacity) {
+                        sink.buffer[sink.length++] = b;
+                    } else {
+                        ok = false;                     // 缓冲区不足
+                    }
+                }
+            } else {
+                uint8_t chunk[FPM383_CHUNK_SIZE];
+                for (uint16_t i = 0; i < n; i++) {
+                    chunk[i] = _ss->read();
+                    _rxSum += chunk[i];
+                }
+                if (ok && sink.callback != NULL && !sink.callback(sink.context, chunk, n)) ok = false;
+                sink.length += n;
+            }
+            _rxCount += n;
+            continue;
+        }
+        bool stream = _rxStream;
+        uint8_t r = feedByte(readByte());
+        if (r == FPM383_RX_ERROR && stream) ok = false; // 数据包校验和错误
+        if (r != FPM383_RX_DONE) continue;
+        start = millis();
+        if (PS_ReceiveBuffer[6] == FPM383_PID_END) {
+            _sinkActive = false;
+            _transferBytes = sink.length;
+            _transferMicros = micros() - begin;
+            _lastError = ok ? FPM383_ERROR_NONE : _rxError ? FPM383_ERROR_BAD_PACKET : FPM383_ERROR_ABORTED;
+            return ok;
+        }
+        if (PS_ReceiveBuffer[6] != FPM383_PID_DATA) ok = false;
+    }
+    _sinkActive = false;
+    resetReceive();
+    receiveFailed();
+    return false;
+}
+
+/**
+  * @brief   按数据包大小分包发送数据，最后一包为结束包。缓冲区模式直接从调用者缓冲区发送，
+  *          回调模式边读取边发送，均不需要整包大小的缓冲区。
+  *          回调提供的数据不足时不再调用回调，其余字节以0补足：包头已声明长度，模组会一直等待剩余数据，
+  *          中途停止会把之后的指令当作模板数据；补足后模组恢复接收指令，特征缓冲区中为无效数据
+  * @param   source：发送源
+  * @return  true：全部发送；false：回调提供的数据不足
+  */
+bool YFROBOTFPM383::sendDataPackets(FPM383DataSource &source)
+{
+    bool ok = true;
+    uint32_t offset = 0;
+    while (offset < source.length) {
+        uint16_t n = source.length - offset > _packetSize ? _packetSize : source.length - offset;
+        uint8_t pid = offset + n < source.length ? FPM383_PID_DATA : FPM383_PID_END;
+        if (source.buffer != NULL) {
+            sendPacket(pid, source.buffer + offset, n);
+        } else {
+            uint16_t length = n + 2;
+            uint8_t head[FPM383_HEADER_SIZE] = { 0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, pid, (uint8_t)(length >> 8), (uint8_t)length };
+            uint16_t sum = pid + (length >> 8) + (length & 0xFF);
+            _ss->write(head, FPM383_HEADER_SIZE);
+            for (uint16_t done = 0; done < n; ) {
+                uint8_t chunk[FPM383_CHUNK_SIZE];
+                uint16_t m = n - done > FPM383_CHUNK_SIZE ? FPM383_CHUNK_SIZE : n - done;
+                if (ok && (source.callback == NULL || source.callback(source.context, chunk, m) != m)) ok = false;
+                if (!ok) memset(chunk, 0, m);
+                for (uint16_t i = 0; i < m; i++) sum += chunk[i];
+                _ss->write(chunk, m);
+                done += m;
+            }
+            uint8_t tail[2] = { (uint8_t)(sum >> 8), (uint8_t)sum };
+            _ss->write(tail, 2);
+            FPM383_STAT(if (_statOp != NULL) { _statOp->bytesSent += n + 11; _statBytes += n + 11; });
+            FPM383_POWER_STAT(powerSent(n + 11, false));
+        }
+        offset += n;
+    }
+    return ok;
+}
+
+/**
+  * @brief   将 flash 指纹库中的模板读入特征缓冲区
+  * @param   bufferID：特征缓冲区号
+  * @param   PageID：指纹ID号
+  * @return  应答包第9位确认码或者无效值0xFF
+  */
+uint8_t YFROBOTFPM383::loadChar(uint8_t bufferID, uint16_t PageID)
+{
+    FPM383Response response;
+    return loadChar(bufferID, PageID, response);
+}
+
+uint8_t YFROBOTFPM383::loadChar(uint8_t bufferID, uint16_t PageID, FPM383Response &response)
+{
+    if (!checkRange(PageID, 1, response)) return response.code;
+    uint8_t cmd[4] = { PS_LOAD_CHAR, bufferID, (uint8_t)(PageID >> 8), (uint8_t)PageID };
+    return request(cmd, sizeof(cmd), response);
+}
+
+/**
+  * @brief   将特征缓冲区中的模板存入 flash 指纹库
+  * @param   bufferID：特征缓冲区号
+  * @param   PageID：指纹ID号
+  * @return  应答包第9位确认码或者无效值0xFF
+  */
+uint8_t YFROBOTFPM383::storeChar(uint8_t bufferID, uint16_t PageID)
+{
+    FPM383Response response;
+    return storeChar(bufferID, PageID, response);
+}
+
+uint8_t YFROBOTFPM383::storeChar(uint8_t bufferID, uint16_t PageID, FPM383Response &response)
+{
+    if (!checkRange(PageID, 1, response)) return response.code;
+    uint8_t cmd[4] = { PS_STORE_CHAR, bufferID, (uint8_t)(PageID >> 8), (uint8_t)PageID };
+    if (request(cmd, sizeof(cmd), response) == 0x00) markIndex(PageID, true);
+    return response.code;
+}
+
+/**
+  * @brief   上传特征缓冲区中的模板，数据包到达时即写入接收端
+  * @param   bufferID：特征缓冲区号
+  * @param   sink：接收端，sink.length 返回模板字节数
+  * @return  确认码；数据包超时、校验错误、缓冲区不足或回调中止返回0xFF
+  */
+uint8_t YFROBOTFPM383::upChar(uint8_t bufferID, FPM383DataSink &sink)
+{
+    uint8_t cmd[2] = { PS_UP_CHAR, bufferID };
+    uint8_t code = command(cmd, sizeof(cmd), 2000);
+    if (code != 0x00) return code;
+    return receiveDataPackets(sink, 2000) ? 0x00 : 0xFF;
+}
+
+/**
+  * @brief   上传图像缓冲区中的原始图像（getImage() 采集），数据包到达时即写入接收端。
+  *          图像约 25KB，57600 波特率需约5秒，建议先 setBaudRate(115200)
+  * @param   sink：接收端，sink.length 返回图像字节数
+  * @return  确认码（0x15 图像缓冲区内没有有效图像）；数据包超时、校验错误、缓冲区不足或回调中止返回0xFF
+  */
+uint8_t YFROBOTFPM383::upImage(FPM383DataSink &sink)
+{
+    uint8_t cmd[1] = { PS_UP_IMAGE };
+    uint8_t code = command(cmd, sizeof(cmd), 2000);
+    if (code != 0x00) return code;
+    return receiveDataPackets(sink, 2000) ? 0x00 : 0xFF;
+}
+
+/**
+  * @brief   上传原始图像到调用者缓冲区
+  * @param   buffer：图像缓冲区，至少 FPM383_IMAGE_SIZE 字节
+  * @param   capacity：缓冲区大小
+  * @param   length：返回图像字节数，可为NULL
+  * @return  确认码或者无效值0xFF
+  */
+uint8_t YFROBOTFPM383::upImage(uint8_t *buffer, uint32_t capacity, uint32_t *length)
+{
+    FPM383DataSink sink = { buffer, capacity, NULL, NULL, 0, NULL };
+    uint8_t code = upImage(sink);
+    if (length != NULL) *length = sink.length;
+    return code;
+}
+
+/**
+  * @brief   上传原始图像到环形缓冲区，其他任务/线程同时读出
+  * @param   ring：环形缓冲区
+  * @return  确认码或者无效值0xFF；读取方在数据包超时前未腾出空间返回0xFF
+  */
+uint8_t YFROBOTFPM383::upImage(FPM383RingBuffer &ring)
+{
+    FPM383DataSink sink = { NULL, 0, NULL, NULL, 0, &ring };
+    return upImage(sink);
+}
+
+/**
+  * @brief   最近一次完整接收的多包上传（图像、模板）的速率，从开始接收数据包到结束包
+  * @return  字节/秒
+  */
+uint32_t YFROBOTFPM383::transferRate()
+{
+    if (_transferMicros == 0) return 0;
+    return (uint64_t)_transferBytes * 1000000UL / _transferMicros;
+}
+
+/**
+  * @brief   下载模板到特征缓冲区
+  * @param   bufferID：特征缓冲区号
+  * @param   source：发送源
+  * @return  确认码；发送源数据不足返回0xFF
+  */
+uint8_t YFROBOTFPM383::downChar(uint8_t bufferID, FPM383DataSource &source)
+{
+    uint8_t cmd[2] = { PS_DOWN_CHAR, bufferID };
+    uint8_t code = command(cmd, sizeof(cmd), 2000);
+    if (code != 0x00) return code;
+    if (sendDataPackets(source)) return 0x00;
+    _lastError = FPM383_ERROR_ABORTED;
+    return 0xFF;
+}
+
+/**
+  * @brief   备份指纹库中的模板：读出到特征缓冲区1后上传
+  * @param   PageID：指纹ID号
+  * @param   sink：接收端
+  * @return  确认码或者无效值0xFF
+  */
+uint8_t YFROBOTFPM383::uploadTemplate(uint16_t PageID, FPM383DataSink &sink)
+{
+    uint8_t code = loadChar(1, PageID);
+    if (code != 0x00) return code;
+    return upChar(1, sink);
+}
+
+/**
+  * @brief   备份指纹库中的模板到调用者缓冲区
+  * @param   PageID：指纹ID号
+  * @param   buffer：模板缓冲区
+  * @param   capacity：缓冲区大小
+  * @param   length：返回模板字节数，可为NULL
+  * @return  确认码或者无效值0xFF
+  */
+uint8_t YFROBOTFPM383::uploadTemplate(uint16_t PageID, uint8_t *buffer, uint32_t capacity, uint32_t *length)
+{
+    FPM383DataSink sink = { buffer, capacity, NULL, NULL, 0, NULL };
+    uint8_t code = uploadTemplate(PageID, sink);
+    if (length != NULL) *length = sink.length;
+    return code;
+}
+
+/**
+  * @brief   恢复模板到指纹库：下载到特征缓冲区1后存入指定ID
+  * @param   PageID：指纹ID号
+  * @param   source：发送源
+  * @return  确认码或者无效值0xFF
+  */
+uint8_t YFROBOTFPM383::downloadTemplate(uint16_t PageID, FPM383DataSource &source)
+{
+    uint8_t code = downChar(1, source);
+    if (code != 0x00) return code;
+    return storeChar(1, PageID);
+}
+
+/**
+  * @brief   从调用者缓冲区恢复模板到指纹库
+  * @param   PageID：指纹ID号
+  * @param   buffer：模板数据
+  * @param   length：模板字节数
+  * @return  确认码或者无效值0xFF
+  */
+uint8_t YFROBOTFPM383::downloadTemplate(uint16_t PageID, const uint8_t *buffer, uint32_t length)
+{
+    FPM383DataSource source = { buffer, length, NULL, NULL };
+    return downloadTemplate(PageID, source);
+}
+
+/**
+  * @brief   读取模组索引表，建立主机端指纹库占用位图。指纹库容量超出 FPM383_MAX_IDS 时只跟踪前 FPM383_MAX_IDS 个ID，
+  *          indexValid() 为 false，lastError() 为 FPM383_ERROR_RANGE
+  * @param   None
+  * @return  true：读取成功
+  */
+bool YFROBOTFPM383::loadIndex()
+{
+    uint16_t ids = _capacity < FPM383_MAX_IDS ? _capacity : FPM383_MAX_IDS;
+    for (uint8_t page = 0; page * INDEX_PAGE_IDS < ids; page++) {
+        uint8_t cmd[2] = { PS_READ_INDEX_TABLE, page };
+        FPM383Response response;
+        sendPacket(FPM383_PID_COMMAND, cmd, sizeof(cmd));
+        if (receiveResponse(response, 2000, INDEX_PAGE_IDS / 8) != 0x00) {
+            _indexValid = false;
+            return false;
+        }
+        for (uint16_t i = 0; i < INDEX_PAGE_IDS / 8 && i < response.length && page * INDEX_PAGE_IDS + i * 8 < FPM383_MAX_IDS; i++) {
+            _index[page * (INDEX_PAGE_IDS / 8) + i] = response.params[i];
+        }
+    }
+    _indexValid = _capacity <= FPM383_MAX_IDS;
+    if (!_indexValid) _lastError = FPM383_ERROR_RANGE;     // 位图之外的ID未跟踪
+    return true;
+}
+
+/**
+  * @brief   位图是否已从模组读取且覆盖整个指纹库。未读取时查询结果仅反映本次运行中注册、删除的ID；
+  *          指纹库容量超出 FPM383_MAX_IDS 时，之后的ID不在位图中
+  */
+bool YFROBOTFPM383::indexValid()
+{
+    return _indexValid;
+}
+
+/**
+  * @brief   更新位图中一个ID的占用状态
+  */
+void YFROBOTFPM383::markIndex(uint16_t id, bool enrolled)
+{
+    if (id >= FPM383_MAX_IDS) return;
+    if (enrolled) {
+        _index[id >> 3] |= (1 << (id & 7));
+    } else {
+        _index[id >> 3] &= ~(1 << (id & 7));
+    }
+}
+
+/**
+  * @brief   查询ID是否已注册，不与模组通信
+  * @param   PageID：指纹ID号
+  * @return  bool；ID不小于 FPM383_MAX_IDS 时不在位图中，无法确定，返回 false
+  */
+bool YFROBOTFPM383::isEnrolled(uint16_t PageID)
+{
+    return PageID < FPM383_MAX_IDS && (_index[PageID >> 3] & (1 << (PageID & 7)));
+}
+
+/**
+  * @brief   查找第一个未注册的ID，不与模组通信
+  * @param   from：起始ID
+  * @return  未注册的ID；指纹库已满返回 FPM383_NO_ID；
+  *          位图内已满但指纹库容量超出 FPM383_MAX_IDS 返回 FPM383_ID_UNTRACKED（之后的ID可能空闲，需增大 FPM383_MAX_IDS）
+  */
+uint16_t YFROBOTFPM383::nextFreeId(uint16_t from)
+{
+    uint16_t ids = _capacity < FPM383_MAX_IDS ? _capacity : FPM383_MAX_IDS;
+    for (uint16_t id = from; id < ids; id++) {
+        if (_index[id >> 3] == 0xFF) {          // 整字节已占用，跳到下一字节
+            id |= 7;
+            continue;
+        }
+        if (!isEnrolled(id)) return id;
+    }
+    return _capacity > FPM383_MAX_IDS ? FPM383_ID_UNTRACKED : FPM383_NO_ID;
+}
+
+/**
+  * @brief   查找第一个已注册的ID，用于遍历：
+  *          for (uint16_t id = fpm.nextEnrolled(0); id != FPM383_NO_ID; id = fpm.nextEnrolled(id + 1))
+  * @param   from：起始ID
+  * @return  已注册的ID；没有更多返回 FPM383_NO_ID
+  */
+uint16_t YFROBOTFPM383::nextEnrolled(uint16_t from)
+{
+    for (uint16_t id = from; id < FPM383_MAX_IDS; id++) {
+        if (_index[id >> 3] == 0x00) {          // 整字节为空，跳到下一字节
+            id |= 7;
+            continue;
+        }
+        if (isEnrolled(id)) return id;
+    }
+    return FPM383_NO_ID;
+}
+
+/**
+  * @brief   位图中已注册的ID数量
+  */
+uint16_t YFROBOTFPM383::enrolledCount()
+{
+    uint16_t n = 0;
+    for (uint16_t i = 0; i < sizeof(_index); i++) {
+        for (uint8_t b = _index[i]; b; b &= b - 1) n++;
+    }
+    return n;
+}
+
+/**
+  * @brief   一站式自动验证指纹，一次往返完成采集图像、生成特征、搜索，比分步式 identify() 少两次往返。
+  *          节省的只是两次往返的传输时间（57600 波特率约 6 ms），采图、生成特征、搜索的模组处理时间不变且占识别时间的大部分
+  *          模组会等待手指按下直至超时，建议在检测到手指（如 TOUCHOUT 引脚）后调用
+  * @param   NoFingerLED：无手指（超时）时是否闪烁红绿色灯一次
+  * @param   securityLevel：分数等级，取值1~5
+  * @param   PageID：FPM383_SEARCH_ALL 搜索整个指纹库，否则只与该ID比对
+  * @param   Timeout：等待应答超时时间（ms），超时后发送取消指令
+  * @return  指纹ID；搜索到未认证手指返回0xFE；无手指或失败返回0xFF；得分见 score()
+  */
+uint8_t YFROBOTFPM383::autoIdentify(bool NoFingerLED, uint8_t securityLevel, uint16_t PageID, uint16_t Timeout)
+{
+    if (!beginAutoIdentify(NoFingerLED, securityLevel, PageID, Timeout)) return 0xFF;
+    while (poll() == FPM383_BUSY)
+        ;
+    return _asyncResult;
+}
+
+/**
+  * @brief   开始异步识别指纹，发送获取图像指令后立即返回，之后循环调用 poll()
+  *          工作流程与 identify() 相同：获取图像 -> 生成特征 -> 搜索指纹
+  * @param   NoFingerLED：无手指时是否闪烁红绿色灯一次
+  * @param   start：搜索的起始ID
+  * @param   count：搜索的ID个数，FPM383_SEARCH_ALL 为起始ID之后全部
+  * @return  true：已开始；false：已有操作进行中或起始ID超出指纹库容量（lastError() 为 FPM383_ERROR_RANGE）
+  */
+bool YFROBOTFPM383::beginIdentify(bool NoFingerLED, uint16_t start, uint16_t count)
+{
+    if (_asyncOp != FPM383_OP_NONE || outOfRange(start)) return false;
+    _asyncOp = FPM383_OP_IDENTIFY;
+    _asyncNoFingerLED = NoFingerLED;
+    _searchStart = start;
+    _searchCount = searchCount(start, count);
+    FPM383_POWER_STAT(_powerFinger = false);
+    asyncSend(STEP_GET_IMAGE, 2000);
+    return true;
+}
+
+/**
+  * @brief   开始异步注册指纹，点亮蓝灯后发送自动注册指令，之后循环调用 poll()
+  * @param   PageID：注册指纹的ID号，取值0 ~ capacity()-1（FPM383F 为0 - 49）
+  * @param   entriesCount：录入（拼接）次数，取值1~12，推荐4~6
+  * @return  true：已开始；false：已有操作进行中或ID超出指纹库容量（lastError() 为 FPM383_ERROR_RANGE）
+  */
+bool YFROBOTFPM383::beginEnroll(uint16_t PageID, uint8_t entriesCount)
+{
+    if (_asyncOp != FPM383_OP_NONE || outOfRange(PageID)) return false;
+    _asyncOp = FPM383_OP_ENROLL;
+    _enrollID = PageID;
+    _enrollCount = entriesCount > 12 ? 12 : entriesCount;
+    SEND_PIPELINED(PS_BlueLED);    // 点亮蓝灯，注册开始；不等待应答，应答到达后由 poll() 发送自动注册指令
+    asyncSend(STEP_AUTO_ENROLL, 10000, 2);
+    return true;
+}
+
+/**
+  * @brief   开始异步自动验证指纹，发送自动验证指令后立即返回，之后循环调用 poll()
+  * @param   参数同 autoIdentify()
+  * @return  true：已开始；false：已有操作进行中或ID超出指纹库容量（lastError() 为 FPM383_ERROR_RANGE）
+  */
+bool YFROBOTFPM383::beginAutoIdentify(bool NoFingerLED, uint8_t securityLevel, uint16_t PageID, uint16_t Timeout)
+{
+    if (_asyncOp != FPM383_OP_NONE || (PageID != FPM383_SEARCH_ALL && outOfRange(PageID))) return false;
+    _asyncOp = FPM383_OP_AUTO_IDENTIFY;
+    _asyncNoFingerLED = NoFingerLED;
+    FPM383_POWER_STAT(_powerFinger = false);
+    _autoSecurity = securityLevel;
+    _autoPageID = PageID;
+    asyncSend(STEP_AUTO_IDENTIFY, Timeout, 5);
+    return true;
+}
+
+/**
+  * @brief   推进异步操作：读取串口已到达的字节，收到完整应答包后发送下一条指令
+  *          不会阻塞等待，可与其他任务在同一个 loop() 中运行
+  * @param   None
+  * @return  FPM383_IDLE / FPM383_BUSY / FPM383_DONE
+  */
+uint8_t YFROBOTFPM383::poll()
+{
+    if (_asyncOp == FPM383_OP_NONE) {
+        if (_pendingAcks > 0) serviceInput();   // 空闲时处理流水线指令的应答
+        if (!_touchMode) return FPM383_IDLE;
+        if (!_touchAsleep) {                    // 低功耗识别模式：先让模组休眠
+            if (_touchSleepFailed && millis() - _touchSleepAt < FPM383_TOUCH_RETRY) return FPM383_IDLE;    // 休眠失败，稍后重试
+            _touchSleepFailed = true;           // 休眠成功应答时清除
+            _touchSleepAt = millis();
+            beginSleep();
+            return FPM383_BUSY;
+        }
+        if (!touched()) return FPM383_IDLE;     // 休眠等待触摸，不收发任何数据
+        FPM383_POWER_STAT(_powerNewEvent = true);   // 每次触摸为新的手指事件
+        beginAutoIdentify(_touchNoFingerLED, _touchSecurity, FPM383_SEARCH_ALL, FPM383_TOUCH_TIMEOUT);
+        return FPM383_BUSY;
+    }
+    while (rxAvailable()) {
+        if (feedByte(readByte()) == FPM383_RX_DONE && !consumeAck() && _asyncStep != STEP_ACKS) {
+            _lastError = FPM383_ERROR_NONE;
+            FPM383_STAT(statReply());
+            asyncStep();
+            if (_asyncOp == FPM383_OP_NONE) return FPM383_DONE;
+        }
+    }
+    if (_asyncStep == STEP_ACKS) {              // 流水线指令应答已处理或超时后，发送本步骤的指令
+        if (_pendingAcks > 0 && millis() - _ackSent < FPM383_ACK_TIMEOUT) return FPM383_BUSY;
+        _acksLost += _pendingAcks;
+        _pendingAcks = 0;
+        if (_asyncNext == STEP_DISCARD) {       // 指令发送前已取消
+            if (_asyncOp == FPM383_OP_ENROLL) SEND_PIPELINED(PS_OFFLED);
+            asyncFinish(FPM383_RESULT_CANCELLED);
+            return FPM383_DONE;
+        }
+        asyncCommand(_asyncNext);
+        asyncWait(_asyncNext, _asyncNextTimeout, _asyncNextParams);
+        return FPM383_BUSY;
+    }
+    if (millis() - _asyncStart >= _asyncTimeout) {
+        memset(PS_ReceiveBuffer, 0xFF, sizeof(PS_ReceiveBuffer));
+        receiveFailed();
+        if (_asyncOp == FPM383_OP_ENROLL) SEND_PIPELINED(PS_OFFLED);  // 注册超时，全灭
+        if (_asyncOp == FPM383_OP_AUTO_IDENTIFY) SEND_PIPELINED(PS_Cancel);   // 停止模组等待手指
+        asyncFinish(0xFF);                      // 超时
+        return FPM383_DONE;
+    }
+    return FPM383_BUSY;
+}
+
+/**
+  * @brief   取消正在进行的异步操作。自动注册/自动验证立即发送取消指令（0x30），模组停止等待手指；
+  *          分步式识别在当前指令应答到达后结束。结果为 FPM383_RESULT_CANCELLED，仍需调用 poll() 直至完成
+  * @param   None
+  * @return  true：已请求取消；false：没有正在进行的操作
+  */
+bool YFROBOTFPM383::abort()
+{
+    if (_asyncOp == FPM383_OP_NONE) return false;
+    if (_asyncStep == STEP_AUTO_ENROLL || _asyncStep == STEP_AUTO_IDENTIFY) {
+        asyncSend(STEP_CANCEL, 2000);
+    } else if (_asyncStep == STEP_ACKS) {      // 指令尚未发送，无需取消指令；已发送的自动注册/验证仍需取消
+        if (_asyncNext != STEP_CANCEL) _asyncNext = STEP_DISCARD;
+    } else if (_asyncStep != STEP_CANCEL) {
+        _asyncStep = STEP_DISCARD;
+    }
+    return true;
+}
+
+/**
+  * @brief   设置自动注册进度回调，设置后 enroll()/beginEnroll()/autoEnroll() 开启关键步骤状态返回
+  * @param   callback：每收到一个状态包调用一次，返回 false 立即取消注册；NULL 关闭状态返回
+  * @return  None
+  */
+void YFROBOTFPM383::onEnrollProgress(FPM383ProgressCallback callback)
+{
+    _progress = callback;
+}
+
+#if !defined(ESP32)
+YFROBOTFPM383 *YFROBOTFPM383::_touchSlots[FPM383_TOUCH_MAX] = { NULL, NULL, NULL, NULL };
+#endif
+
+/**
+  * @brief   TOUCHOUT 上升沿中断
+  */
+void IRAM_ATTR YFROBOTFPM383::touchISR(void *arg)
+{
+    if (arg != NULL) ((YFROBOTFPM383 *)arg)->_touched = true;
+}
+
+/**
+  * @brief   配置 TOUCHOUT 引脚。引脚支持外部中断时使用上升沿中断，否则在 poll()/touched() 中查询电平
+  * @param   touchPin：接模组 TOUCHOUT 的引脚
+  * @return  true：使用外部中断；false：查询模式
+  */
+bool YFROBOTFPM383::touchBegin(int touchPin)
+{
+    touchEnd();
+    _touchPin = touchPin;
+    _touched = false;
+    pinMode(touchPin, INPUT);
+    _touchLevel = digitalRead(touchPin);
+    int interrupt = digitalPinToInterrupt(touchPin);
+    if (interrupt == NOT_AN_INTERRUPT) return false;
+#if defined(ESP32)
+    attachInterruptArg(interrupt, touchISR, this, RISING);
+    _touchInterrupt = true;
+#else
+    static void (*const trampolines[FPM383_TOUCH_MAX])() = {
+        touchTrampoline<0>, touchTrampoline<1>, touchTrampoline<2>, touchTrampoline<3>
+    };
+    for (uint8_t i = 0; i < FPM383_TOUCH_MAX; i++) {
+        if (_touchSlots[i] != NULL) continue;
+        _touchSlots[i] = this;
+        attachInterrupt(interrupt, trampolines[i], RISING);
+        _touchInterrupt = true;
+        break;
+    }
+#endif
+    return _touchInterrupt;
+}
+
+/**
+  * @brief   释放 TOUCHOUT 引脚及中断，并退出低功耗识别模式
+  */
+void YFROBOTFPM383::touchEnd()
+{
+    _touchMode = false;
+    if (_touchPin < 0) return;
+    if (_touchInterrupt) detachInterrupt(digitalPinToInterrupt(_touchPin));
+#if !defined(ESP32)
+    for (uint8_t i = 0; i < FPM383_TOUCH_MAX; i++) {
+        if (_touchSlots[i] == this) _touchSlots[i] = NULL;
+    }
+#endif
+    _touchPin = -1;
+    _touchInterrupt = false;
+}
+
+/**
+  * @brief   查询模式下读取引脚电平，检测上升沿
+  */
+void YFROBOTFPM383::touchSample()
+{
+    if (_touchPin < 0 || _touchInterrupt) return;
+    uint8_t level = digitalRead(_touchPin);
+    if (level == HIGH && _touchLevel == LOW) _touched = true;
+    _touchLevel = level;
+}
+
+/**
+  * @brief   自上次调用以来是否检测到触摸（TOUCHOUT 上升沿），读取后清除
+  */
+bool YFROBOTFPM383::touched()
+{
+    touchSample();
+    bool t = _touched;
+    _touched = false;
+    return t;
+}
+
+/**
+  * @brief   开始异步休眠，应答后 TOUCHOUT 变为低电平，之后发送任意指令即唤醒模组
+  * @return  true：已开始；false：已有操作进行中
+  */
+bool YFROBOTFPM383::beginSleep()
+{
+    if (_asyncOp != FPM383_OP_NONE) return false;
+    _asyncOp = FPM383_OP_SLEEP;
+    asyncSend(STEP_SLEEP, 2000);
+    return true;
+}
+
+/**
+  * @brief   进入低功耗识别模式：poll() 令模组休眠，检测到触摸后发送自动验证指令，完成后再次休眠。
+  *          等待触摸期间不收发任何数据；结果与 beginAutoIdentify() 相同，通过 onComplete() 回调获得
+  *          手指一直按住时不会重复识别，需抬起后再次按下；休眠失败时每隔 FPM383_TOUCH_RETRY 重试
+  * @param   NoFingerLED：无手指（超时）时是否闪烁红绿色灯一次
+  * @param   securityLevel：分数等级，取值1~5
+  * @return  false：未调用 touchBegin()
+  */
+bool YFROBOTFPM383::beginTouchIdentify(bool NoFingerLED, uint8_t securityLevel)
+{
+    if (_touchPin < 0) return false;
+    _touchMode = true;
+    _touchSleepFailed = false;
+    _touchNoFingerLED = NoFingerLED;
+    _touchSecurity = securityLevel;
+    return true;
+}
+
+/**
+  * @brief   退出低功耗识别模式，模组保持当前状态（休眠时发送任意指令即唤醒）
+  */
+void YFROBOTFPM383::endTouchIdentify()
+{
+    _touchMode = false;
+}
+
+/**
+  * @brief   是否有异步操作正在进行
+  */
+bool YFROBOTFPM383::busy()
+{
+    return _asyncOp != FPM383_OP_NONE;
+}
+
+/**
+  * @brief   最近一次完成的异步操作结果，含义与 identify()/enroll() 返回值相同
+  */
+uint8_t YFROBOTFPM383::result()
+{
+    return _asyncResult;
+}
+
+/**
+  * @brief   最近一次识别成功的比对得分（identify()/autoIdentify() 及对应异步操作）
+  */
+uint16_t YFROBOTFPM383::score()
+{
+    return _asyncScore;
+}
+
+/**
+  * @brief   设置异步操作完成回调
+  * @param   callback：完成时在 poll() 中调用，NULL 表示不使用回调
+  * @return  None
+  */
+void YFROBOTFPM383::onComplete(FPM383Callback callback)
+{
+    _callback = callback;
+}
+
+/**
+  * @brief   当前步骤的指令已发送，开始等待应答包并计时
+  * @param   params：成功应答的参数字节数，同 receiveResponse()
+  */
+void YFROBOTFPM383::asyncWait(uint8_t step, uint16_t Timeout, uint8_t params)
+{
+    _expectParams = params;
+    _rxError = false;
+    _rxAny = false;
+    _asyncStep = step;
+    _asyncTimeout = Timeout;
+    _asyncStart = millis();
+}
+
+/**
+  * @brief   发送步骤的指令并开始等待应答。有未读的流水线指令应答时不等待，先进入 STEP_ACKS，
+  *          由 poll() 处理应答（最长 FPM383_ACK_TIMEOUT）后再发送，避免把只有确认码的应答当作流水线指令的应答
+  * @param   参数同 asyncWait()
+  */
+void YFROBOTFPM383::asyncSend(uint8_t step, uint16_t Timeout, uint8_t params)
+{
+    if (_pendingAcks > 0) serviceInput();       // 只处理已到达的字节
+    if (_pendingAcks > 0) {
+        _asyncNext = step;
+        _asyncNextTimeout = Timeout;
+        _asyncNextParams = params;
+        _asyncStep = STEP_ACKS;
+        return;
+    }
+    asyncCommand(step);
+    asyncWait(step, Timeout, params);
+}
+
+/**
+  * @brief   发送异步操作步骤对应的指令
+  */
+void YFROBOTFPM383::asyncCommand(uint8_t step)
+{
+    switch (step) {
+        case STEP_GET_IMAGE:
+            SEND_PACKET(PS_GetImage);
+            break;
+        case STEP_GET_CHAR:
+            SEND_PACKET(PS_GetChar);
+            break;
+        case STEP_SEARCH:
+            sendSearch(_searchStart, _searchCount);
+            break;
+        case STEP_AUTO_ENROLL:
+            sendAutoEnroll();
+            break;
+        case STEP_AUTO_IDENTIFY: {
+            uint8_t cmd[6] = { PS_AUTO_IDENTIFY, _autoSecurity, (uint8_t)(_autoPageID >> 8), (uint8_t)_autoPageID,
+                               (uint8_t)(PS_AUTO_IDENTIFY_FLAGS >> 8), (uint8_t)PS_AUTO_IDENTIFY_FLAGS };
+            sendPacket(FPM383_PID_COMMAND, cmd, sizeof(cmd));
+            break;
+        }
+        case STEP_CANCEL:
+            SEND_PACKET(PS_Cancel);
+            break;
+        case STEP_SLEEP:
+            SEND_PACKET(PS_Sleep);
+            break;
+    }
+}
+
+/**
+  * @brief   处理当前步骤收到的应答包，决定发送下一条指令或结束操作
+  */
+void YFROBOTFPM383::asyncStep()
+{
+    FPM383Response response;
+    fillResponse(response, true);
+    uint8_t code = response.code;
+    switch (_asyncStep) {
+        case STEP_GET_IMAGE:
+            if (code == 0x00) {
+                FPM383_POWER_STAT(_powerFinger = true);
+                asyncSend(STEP_GET_CHAR, 2000);
+            } else {
+                if (code == 0x02 && _asyncNoFingerLED) {   // 无手指时，闪烁红绿色灯一次
+                    SEND_PIPELINED(PS_RGLEDBlink);
+                }
+                asyncFinish(0xFF);
+            }
+            break;
+        case STEP_GET_CHAR:
+            if (code == 0x00) {
+                asyncSend(STEP_SEARCH, 2000, 4);
+            } else {
+                asyncFinish(0xFF);
+            }
+            break;
+        case STEP_SEARCH:
+            if (code == 0x00) {         // 返回数据校验正确，则识别正常，返回指纹ID并闪烁绿灯两次
+                SEND_PIPELINED(PS_GreenLED);
+                _asyncScore = response.param16(2);
+                markIndex(response.param16(0), true);
+                asyncFinish(response.params[1]);    // 此模组最大支持49个指纹库，所以直接返回ID低字节即可；ID码有2字节
+            } else if (code == 0x17) {
+                asyncFinish(0xFF);
+            } else {                    // 搜索到未认证手指时，闪烁红灯两次
+                SEND_PIPELINED(PS_RedLED);
+                asyncFinish(0xFE);      // 搜索到未认证手指时，默认返回 0xFE
+            }
+            break;
+        case STEP_AUTO_IDENTIFY:    // 应答：确认码 参数 ID号(2) 得分(2)
+            FPM383_POWER_STAT(_powerFinger = code != 0x26);     // 0x26：超时无手指
+            if (code == 0x00) {
+                SEND_PIPELINED(PS_GreenLED);
+                _asyncScore = response.param16(3);
+                markIndex(response.param16(1), true);
+                asyncFinish(response.params[2]);
+            } else if (code == 0x09) {  // 搜索到未认证手指
+                SEND_PIPELINED(PS_RedLED);
+                asyncFinish(0xFE);
+            } else {                    // 无手指超时等
+                if (code == 0x26 && _asyncNoFingerLED) SEND_PIPELINED(PS_RGLEDBlink);
+                asyncFinish(0xFF);
+            }
+            break;
+        case STEP_AUTO_ENROLL: {    // 应答：确认码 步骤 采集次数
+            bool final = enrollFinal(code, response.params[0]);
+            if (_progress != NULL && !_progress(this, response.params[0], response.params[1], code) && !final) {
+                abort();
+            } else if (final) {
+                asyncFinish(enrollResult(code, response.params[0], response.params[1]));
+            } else {
+                asyncWait(STEP_AUTO_ENROLL, 10000, 2);      // 每个步骤重新计时
+            }
+            break;
+        }
+        case STEP_CANCEL:           // 取消前已发出的状态包包长度不为3，忽略并继续等待取消应答
+            if (response.error == FPM383_ERROR_NONE && response.length == 0) {
+                if (_asyncOp == FPM383_OP_ENROLL) SEND_PIPELINED(PS_OFFLED);
+                asyncFinish(FPM383_RESULT_CANCELLED);
+            }
+            break;
+        case STEP_SLEEP:            // 休眠前的电平变化来自模组状态切换，不是触摸
+            _touched = false;
+            if (_touchPin >= 0 && !_touchInterrupt) _touchLevel = digitalRead(_touchPin);
+            _touchAsleep = code == 0x00;
+            if (_touchAsleep) {
+                _touchSleepFailed = false;
+            } else {
+                _lastError = FPM383_ERROR_SLEEP;
+            }
+            FPM383_POWER_STAT(if (code == 0x00) powerSleep(true));
+            asyncFinish(code);
+            break;
+        case STEP_DISCARD:
+            if (_asyncOp == FPM383_OP_ENROLL) SEND_PIPELINED(PS_OFFLED);
+            asyncFinish(FPM383_RESULT_CANCELLED);
+            break;
+        default:
+            asyncFinish(0xFF);
+            break;
+    }
+}
+
+/**
+  * @brief   结束异步操作，保存结果并调用完成回调
+  */
+void YFROBOTFPM383::asyncFinish(uint8_t result)
+{
+    uint8_t op = _asyncOp;
+    _asyncOp = FPM383_OP_NONE;
+    _asyncStep = 0;
+    _expectParams = 0;
+    _asyncResult = result;
+#if FPM383_POWER
+    _power.ops[op].count++;
+    if ((op == FPM383_OP_IDENTIFY || op == FPM383_OP_AUTO_IDENTIFY) && result != FPM383_RESULT_CANCELLED) {
+        _power.identifyAttempts++;
+        if (_powerFinger) {
+            _power.fingerAttempts++;
+            if (_powerNewEvent) _power.fingerEvents++;
+            _powerNewEvent = false;
+        } else {
+            _powerNewEvent = true;              // 手指已离开，下次检测到手指为新的事件
+        }
+    }
+#endif
+    if (_callback != NULL) _callback(this, op, result);
+}
+
+/**
+  * @brief   最近一次等待应答包或数据包的通信结果，用于区分返回值0xFF的原因
+  * @return  FPM383_ERROR_*
+  */
+uint8_t YFROBOTFPM383::lastError()
+{
+    return _lastError;
+}
+
+/**
+  * @brief   已发送但应答尚未处理的流水线指令（LED、休眠）数，应答在之后的收发或空闲时的 poll() 中处理
+  */
+uint8_t YFROBOTFPM383::pendingAcks()
+{
+    return _pendingAcks;
+}
+
+/**
+  * @brief   超过 FPM383_ACK_TIMEOUT 仍未到达的流水线指令应答数
+  */
+uint32_t YFROBOTFPM383::acksLost()
+{
+    return _acksLost;
+}
+
+#if FPM383_STATS
+/**
+  * @brief   开始统计一次指令调用，上一次调用的收发字节数计入直方图
+  * @param   opcode：指令码
+  */
+void YFROBOTFPM383::statBegin(uint8_t opcode)
+{
+    statFlush();
+    _statOp = NULL;
+    for (uint8_t i = 0; i < _stats.count; i++) {
+        if (_stats.ops[i].opcode == opcode) _statOp = &_stats.ops[i];
+    }
+    if (_statOp == NULL && _stats.count < FPM383_STATS_OPS) {   // 统计表已满时不统计新的指令码
+        _statOp = &_stats.ops[_stats.count++];
+        memset(_statOp, 0, sizeof(*_statOp));
+        _statOp->opcode = opcode;
+        _statOp->rttMin = 0xFFFFFFFF;
+    }
+    if (_statOp != NULL) _statOp->calls++;
+    _statStart = micros();
+    _statBytes = 0;
+    _statPending = true;
+    _statReplied = false;
+}
+
+/**
+  * @brief   收到当前指令的应答包，记录往返时间
+  */
+void YFROBOTFPM383::statReply()
+{
+    if (_statOp == NULL || !_statPending || _statReplied) return;
+    uint32_t rtt = micros() - _statStart;
+    _statReplied = true;
+    _statOp->replies++;
+    if (rtt < _statOp->rttMin) _statOp->rttMin = rtt;
+    if (rtt > _statOp->rttMax) _statOp->rttMax = rtt;
+    _statOp->rttSum += rtt;
+    _statOp->rttHist[histBucket(rtt, FPM383_HIST_RTT_MS * 1000UL)]++;
+}
+
+/**
+  * @brief   当前指令调用的收发字节总数计入直方图
+  */
+void YFROBOTFPM383::statFlush()
+{
+    if (_statOp != NULL && _statPending) _statOp->bytesHist[histBucket(_statBytes, FPM383_HIST_BYTES)]++;
+    _statPending = false;
+}
+
+uint8_t YFROBOTFPM383::histBucket(uint32_t value, uint32_t first)
+{
+    uint8_t i = 0;
+    while (i < FPM383_HIST_BUCKETS - 1 && value >= first << i) i++;
+    return i;
+}
+
+/**
+  * @brief   读取通信统计，当前指令调用的字节数同时计入直方图
+  * @return  按指令码首次出现顺序排列的统计表
+  */
+const FPM383Stats &YFROBOTFPM383::stats()
+{
+    statFlush();
+    return _stats;
+}
+
+/**
+  * @brief   读取单个指令码的统计
+  * @param   opcode：指令码，如 0x01 获取图像
+  * @return  统计项，该指令码尚未发送过返回NULL
+  */
+const FPM383OpStats *YFROBOTFPM383::opStats(uint8_t opcode)
+{
+    statFlush();
+    for (uint8_t i = 0; i < _stats.count; i++) {
+        if (_stats.ops[i].opcode == opcode) return &_stats.ops[i];
+    }
+    return NULL;
+}
+
+/**
+  * @brief   清空通信统计
+  */
+void YFROBOTFPM383::resetStats()
+{
+    memset(&_stats, 0, sizeof(_stats));
+    _statOp = NULL;
+    _statStart = 0;
+    _statBytes = 0;
+    _statPending = false;
+    _statReplied = false;
+}
+#endif
+
+#if FPM383_POWER
+/**
+  * @brief   发送一帧，计入当前异步操作；空闲时发送的指令计入 FPM383_OP_NONE 项的次数
+  * @param   bytes：帧长度（含包头及校验和）
+  * @param   command：指令包
+  */
+void YFROBOTFPM383::powerSent(uint16_t bytes, bool command)
+{
+    FPM383PowerOp &op = _power.ops[_asyncOp];
+    op.framesSent++;
+    op.bytesSent += bytes;
+    if (command && _asyncOp == FPM383_OP_NONE) op.count++;
+}
+
+/**
+  * @brief   模组休眠或被指令唤醒，之前的时间计入原状态
+  */
+void YFROBOTFPM383::powerSleep(bool asleep)
+{
+    if (asleep == _powerAsleep) return;
+    powerUpdate();
+    _powerAsleep = asleep;
+    if (asleep) _power.sleeps++;
+}
+
+/**
+  * @brief   上次累计以来的时间计入唤醒或休眠时间
+  */
+void YFROBOTFPM383::powerUpdate()
+{
+    unsigned long now = millis();
+    if (_powerAsleep) {
+        _power.sleepMillis += now - _powerSince;
+    } else {
+        _power.awakeMillis += now - _powerSince;
+    }
+    _powerSince = now;
+}
+
+/**
+  * @brief   读取功耗统计，唤醒/休眠时间累计至当前时刻。
+  *          唤醒时间占比 awakeMillis / (awakeMillis + sleepMillis) 乘以模组唤醒电流即为平均电流的主要部分
+  * @return  统计结果，ops 按 FPM383_OP_* 索引
+  */
+const FPM383PowerStats &YFROBOTFPM383::powerStats()
+{
+    powerUpdate();
+    return _power;
+}
+
+/**
+  * @brief   清空功耗统计，从当前时刻重新计时；模组休眠状态保持不变
+  */
+void YFROBOTFPM383::resetPowerStats()
+{
+    memset(&_power, 0, sizeof(_power));
+    _powerSince = millis();
+    _powerFinger = false;
+    _powerNewEvent = true;
+}
+#endif
+
+/**
+  * @brief   读取有效模板个数，查询当前已注册指纹数量
+  * @param   None
+  * @return  应答包第11位有效数量或者无效值0xFF
   */
 uint8_t YFROBOTFPM383::inquiry()
 {
-    sendData(12, PS_ValidTempleteNumBuffer);
-    receiveData(2000);
-    return PS_ReceiveBuffer[9] == 0x00 ? PS_ReceiveBuffer[11] : 0xFF;
+    FPM383Response response;
+    return inquiry(response) == 0x00 ? response.params[1] : 0xFF;
+}
+
+/**
+  * @brief   查询有效模板个数，成功时 response.param16(0) 为个数
+  * @param   response：应答结构体
+  * @return  确认码或者无效值0xFF
+  */
+uint8_t YFROBOTFPM383::inquiry(FPM383Response &response)
+{
+    SEND_PACKET(PS_ValidTempleteNum);
+    return receiveResponse(response, 2000, 2);
 }
 
 
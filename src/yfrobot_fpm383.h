@@ -12,112 +12,387 @@
 
 #include "Arduino.h"
 
-#ifdef __AVR__
-#include <avr/pgmspace.h>
-#include <SoftwareSerial.h>
-#define SERIAL_CLASS SoftwareSerial
-#elif defined(ESP32)
-#include <pgmspace.h>
-#include <HardwareSerial.h>
-#define SERIAL_CLASS HardwareSerial
-#endif
+#include "fpm383_transport.h"
+#include "fpm383_packet.h"
+#include "fpm383_ring_buffer.h"
+
+#define FPM383_BAUD_DEFAULT     57600   // 模组出厂波特率
+#define FPM383_BAUD_UNIT        9600    // 模组波特率为 N*9600，N 取值1~12
+#define FPM383_PROBE_TIMEOUT    100     // 探测波特率时每次等待应答的时间（ms）
 
 #define RECEIVE_TIMEOUT_VALUE 1000 // Timeout for I2C receive
+#define FPM383_ACK_TIMEOUT      200 // 流水线指令（LED、休眠）应答的最长等待时间（ms），超过视为丢失
+
+#define FPM383_RECEIVE_SIZE     50  // 接收缓冲区大小，超出此长度的包将被丢弃并重新同步
+
+// 帧解析器 feedByte() 返回值
+#define FPM383_RX_BUSY          0   // 帧未接收完成
+#define FPM383_RX_DONE          1   // 收到完整且校验正确的帧
+#define FPM383_RX_ERROR         2   // 校验和错误或包长度非法，已丢弃并重新同步
+
+// 异步操作类型
+#define FPM383_OP_NONE          0
+#define FPM383_OP_IDENTIFY      1   // beginIdentify()
+#define FPM383_OP_ENROLL        2   // beginEnroll()
+#define FPM383_OP_AUTO_IDENTIFY 3   // beginAutoIdentify()
+#define FPM383_OP_SLEEP         4   // beginSleep()
+
+// 触摸唤醒：休眠后 TOUCHOUT 引脚为低电平，手指按下时变为高电平
+#define FPM383_TOUCH_MAX        4       // 非 ESP32 平台可同时使用外部中断的模组数量，超出时在 poll() 中查询引脚电平
+#define FPM383_TOUCH_TIMEOUT    2000    // 检测到触摸后自动验证的超时时间（ms）
+#define FPM383_TOUCH_RETRY      1000    // 低功耗识别模式休眠失败后，再次发送休眠指令的间隔（ms）
+
+// 自动验证指纹 0x32 参数
+#define FPM383_SECURITY_DEFAULT 3       // 分数等级（安全等级），取值1~5，等级越高误识率越低
+#define FPM383_SEARCH_ALL       0xFFFF  // ID号为0xFFFF时搜索整个指纹库（1:N），否则与指定ID比对（1:1）
+
+// 自动注册状态（开启状态返回时由 onEnrollProgress() 设置的回调接收）：stage 为当前步骤，index 为采集次数
+#define FPM383_ENROLL_CHECK     0x00    // 指纹合法性检测
+#define FPM383_ENROLL_IMAGE     0x01    // 获取图像，index 为第几次采集
+#define FPM383_ENROLL_CHAR      0x02    // 生成特征，index 为第几次采集
+#define FPM383_ENROLL_LEAVE     0x03    // 判断手指离开，index 为第几次采集
+#define FPM383_ENROLL_MERGE     0x04    // 合并模板，index 为0xF0
+#define FPM383_ENROLL_VERIFY    0x05    // 注册检验，index 为0xF1
+#define FPM383_ENROLL_STORE     0x06    // 存储模板，index 为0xF2，注册完成
+
+#define FPM383_RESULT_CANCELLED 0xFD    // 异步操作被 abort() 或进度回调取消
+
+// 异步操作 poll() 返回值
+#define FPM383_IDLE             0   // 无正在进行的操作
+#define FPM383_BUSY             1   // 操作进行中
+#define FPM383_DONE             2   // 操作在本次 poll() 中完成，结果见 result()
+
+// 多包数据传输（模板、图像）：数据包载荷大小 32/64/128/256 字节，模组默认 128 字节，begin() 读取模组实际设置
+#define FPM383_PACKET_SIZE_DEFAULT  128
+#define FPM383_PACKET_SIZE_MIN      32
+#define FPM383_DATA_MAX             256     // 最大数据包载荷
+#define FPM383_CHUNK_SIZE           32      // 回调模式下每次交给回调的最大字节数
+
+// 指纹图像：upImage() 上传图像缓冲区，每像素1字节灰度，逐行排列
+#ifndef FPM383_IMAGE_WIDTH
+#define FPM383_IMAGE_WIDTH          160
+#define FPM383_IMAGE_HEIGHT         160
+#endif
+#define FPM383_IMAGE_SIZE           ((uint32_t)FPM383_IMAGE_WIDTH * FPM383_IMAGE_HEIGHT)
+
+// 接收数据回调：data 指向本次收到的数据，返回 false 中止传输
+typedef bool (*FPM383DataCallback)(void *context, const uint8_t *data, uint16_t length);
+// 发送数据回调：向 data 填充 length 字节，返回实际填充字节数，不足 length 视为失败
+typedef uint16_t (*FPM383SourceCallback)(void *context, uint8_t *data, uint16_t length);
+
+// 多包数据接收端：buffer 非 NULL 时数据直接写入调用者缓冲区，ring 非 NULL 时写入环形缓冲区，否则逐块交给回调
+struct FPM383DataSink
+{
+    uint8_t *buffer;
+    uint32_t capacity;
+    FPM383DataCallback callback;
+    void *context;
+    uint32_t length;        // 已接收字节数
+    FPM383RingBuffer *ring;
+};
+
+// 多包数据发送源：buffer 非 NULL 时直接从调用者缓冲区发送，否则逐块向回调读取
+struct FPM383DataSource
+{
+    const uint8_t *buffer;
+    uint32_t length;        // 总字节数
+    FPM383SourceCallback callback;
+    void *context;
+};
+
+// 指纹库占用索引：主机端位图，每个ID占1位
+// FPM383_MAX_IDS 决定 YFROBOTFPM383 对象的大小，只能作为全局编译选项修改（-D、build_opt.h、platformio 的 build_flags），
+// 不能在草图中 #define：库的 .cpp 看不到草图中的定义，两边对象大小不一致会破坏内存
+#ifndef FPM383_MAX_IDS
+#define FPM383_MAX_IDS          64      // 位图覆盖的最大ID数（最大1024）
+#endif
+#define FPM383_CAPACITY_DEFAULT 50      // FPM383F 指纹库容量，ID取值0 - 49；begin() 读取模组实际容量
+#define FPM383_NO_ID            0xFFFF  // nextFreeId()/nextEnrolled() 无结果
+#define FPM383_ID_UNTRACKED     0xFFFE  // nextFreeId()：位图内已满，但指纹库容量超出位图，之后的ID未跟踪
+
+// lastError() 返回值：最近一次等待应答/数据包的通信结果（与模组确认码无关）
+#define FPM383_ERROR_NONE       0   // 收到校验正确的应答包
+#define FPM383_ERROR_NO_REPLY   1   // 超时且未收到任何字节（接线、供电、波特率）
+#define FPM383_ERROR_TIMEOUT    2   // 收到字节但超时前未组成完整的帧
+#define FPM383_ERROR_BAD_PACKET 3   // 收到校验和错误或包长度非法的帧，超时前未收到正确的帧
+#define FPM383_ERROR_ABORTED    4   // 多包传输被中止：缓冲区不足、回调中止或发送源数据不足
+#define FPM383_ERROR_WRONG_PACKET 5 // 收到校验正确的帧，但不是应答包
+#define FPM383_ERROR_RANGE      6   // ID 超出指纹库容量 capacity()，指令未发送
+#define FPM383_ERROR_SLEEP      7   // 休眠指令应答确认码非0，模组未休眠
+
+// 指令应答：由调用者分配，每次调用完整填充，结果不依赖接收缓冲区，也不会被之后的调用覆盖
+#define FPM383_RESPONSE_MAX     32      // 保存的最大参数字节数（芯片序列号、索引表为32字节）
+#define FPM383_CHIP_SN_LENGTH   9       // getChipSN() 返回的序列号长度
+
+struct FPM383Response
+{
+    uint8_t code;                       // 确认码；无有效应答包时为0xFF，取消时为 FPM383_RESULT_CANCELLED
+    uint8_t error;                      // FPM383_ERROR_*
+    uint8_t length;                     // params 中的参数字节数（确认码之后、校验和之前），超出部分被截断
+    uint8_t params[FPM383_RESPONSE_MAX];
+    uint16_t id;                        // 搜索/比对到的指纹ID，否则 FPM383_NO_ID
+    uint16_t score;                     // 比对得分，否则0
+
+    bool ok() const { return error == FPM383_ERROR_NONE && code == 0x00; }
+    uint16_t param16(uint8_t offset) const      // 参数中的16位大端数值，超出 length 返回0
+    {
+        return offset + 1 < length ? (uint16_t)((params[offset] << 8) | params[offset + 1]) : 0;
+    }
+};
+
+// 通信统计：按指令码统计调用次数、超时、校验错误、重新同步、往返时间及传输字节数
+// 默认在 AVR 上关闭（RAM 不足），其他平台开启；定义 FPM383_STATS 为0时完全不编译
+// 统计表是 YFROBOTFPM383 的成员，与 FPM383_MAX_IDS 相同，只能作为全局编译选项修改，不能在草图中 #define
+#ifndef FPM383_STATS
+#if defined(__AVR__)
+#define FPM383_STATS            0
+#else
+#define FPM383_STATS            1
+#endif
+#endif
+
+#if FPM383_STATS
+#ifndef FPM383_STATS_OPS
+#define FPM383_STATS_OPS        24      // 最多统计的指令码种类
+#endif
+// 直方图：往返时间第 i 格统计 < (1<<i) ms，字节数第 i 格统计 < (16<<i) 字节，最后一格统计其余全部
+#define FPM383_HIST_BUCKETS     12
+#define FPM383_HIST_RTT_MS      1
+#define FPM383_HIST_BYTES       16
+
+struct FPM383OpStats
+{
+    uint8_t opcode;
+    uint32_t calls;             // 发送次数
+    uint32_t replies;           // 收到应答次数
+    uint32_t timeouts;          // 等待应答或数据包超时
+    uint32_t checksumErrors;    // 校验和错误
+    uint32_t resyncs;           // 校验和错误或包长度非法后重新同步
+    uint32_t rttMin;            // 往返时间（us）：发送指令 -> 收到应答包
+    uint32_t rttMax;
+    uint64_t rttSum;
+    uint32_t bytesSent;         // 指令包及主机发送的数据包
+    uint32_t bytesReceived;     // 应答包及模组发送的数据包
+    uint32_t rttHist[FPM383_HIST_BUCKETS];
+    uint32_t bytesHist[FPM383_HIST_BUCKETS];   // 每次调用收发字节总数
+};
+
+struct FPM383Stats
+{
+    uint8_t count;              // ops 中的有效项数
+    FPM383OpStats ops[FPM383_STATS_OPS];
+};
+#endif
+
+// 功耗统计：模组唤醒/休眠时间、每种操作的收发帧数及字节数、识别尝试次数与手指事件，用于估算电池供电时的占空比
+// 默认与 FPM383_STATS 相同；定义 FPM383_POWER 为0时完全不编译
+// 同样是 YFROBOTFPM383 的成员，只能作为全局编译选项修改，不能在草图中 #define
+#ifndef FPM383_POWER
+#define FPM383_POWER            FPM383_STATS
+#endif
+
+#if FPM383_POWER
+#define FPM383_POWER_OPS        5       // 按 FPM383_OP_NONE ~ FPM383_OP_SLEEP 分别统计
+
+// 收发时正在进行的异步操作（同步 identify()/enroll() 由异步操作实现）；FPM383_OP_NONE 项为其他指令
+struct FPM383PowerOp
+{
+    uint32_t count;             // 完成次数；FPM383_OP_NONE 项为空闲时发送的指令数
+    uint32_t framesSent;        // 指令包及主机发送的数据包
+    uint32_t framesReceived;    // 校验正确的应答包及数据包
+    uint32_t bytesSent;
+    uint32_t bytesReceived;
+};
+
+struct FPM383PowerStats
+{
+    uint32_t awakeMillis;       // 模组唤醒时间
+    uint32_t sleepMillis;       // 模组休眠时间（休眠指令发出后至下一条指令）
+    uint32_t sleeps;            // 进入休眠次数
+    uint32_t identifyAttempts;  // 识别尝试：identify()、autoIdentify() 及触摸唤醒识别
+    uint32_t fingerAttempts;    // 其中检测到手指的次数
+    uint32_t fingerEvents;      // 手指事件：上一次尝试无手指或检测到新的触摸后，首次检测到手指
+    FPM383PowerOp ops[FPM383_POWER_OPS];
+};
+#endif
+
+class YFROBOTFPM383;
+// 异步操作完成回调：op 为操作类型，result 与同步函数 identify()/enroll() 返回值含义相同
+typedef void (*FPM383Callback)(YFROBOTFPM383 *fpm, uint8_t op, uint8_t result);
+// 自动注册进度回调：code 为该步骤的确认码（非0表示该次采集失败），返回 false 立即取消注册
+typedef bool (*FPM383ProgressCallback)(YFROBOTFPM383 *fpm, uint8_t stage, uint8_t index, uint8_t code);
 
 class YFROBOTFPM383
 {
   private:
-    
-    uint8_t PS_ReceiveBuffer[50];  //串口接收数据的临时缓冲数组
-
-    /********************************************** 指纹模块 指令集 ************************************************/
-    //指令/命令包格式：                  包头0xEF01  设备地址4bytes 包标识1byte 包长度2bytes 指令码1byte  参数1......参数N  校验和2bytes
-    
-    //获取芯片唯一序列号 0x34。确认码=00H 表示 OK；确认码=01H 表示收包有错。
-    uint8_t PS_GetChipSN[13]        = { 0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x00, 0x04, 0x34, 0x00, 0x00, 0x39 };
-    //获取模组基本参数 0x0F，读取模组的基本参数（波特率，包大小等）。参数表前 16 个字节存放了模组的基本通讯和配置信息，称为模组的基本参数。
-    uint8_t PS_ReadSysPara[12]      = { 0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x00, 0x03, 0x0F, 0x00, 0x13 };
-
-    //验证用获取图像 0x01，验证指纹时，探测手指，探测到后录入指纹图像存于图像缓冲区。返回确认码表示：录入成功、无手指等。
-    uint8_t PS_GetImageBuffer[12]   = { 0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x00, 0x03, 0x01, 0x00, 0x05 };
-    // 生成特征 0x02，将图像缓冲区中的原始图像生成指纹特征文件存于模板缓冲区。
-    uint8_t PS_GetCharBuffer[13]    = { 0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x00, 0x04, 0x02, 0x01, 0x00, 0x08 };
-    // uint8_t PS_GetChar2Buffer[13]   = { 0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x00, 0x04, 0x02, 0x02, 0x00, 0x09 };
-    // 搜索指纹 0x04，以模板缓冲区中的特征文件搜索整个或部分指纹库。若搜索到，则返回页码。加密等级设置为 0 或 1 情况下支持此功能。
-    uint8_t PS_SearchMBBuffer[17]   = { 0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x00, 0x08, 0x04, 0x01, 0x00, 0x00, 0xFF, 0xFF, 0x02, 0x0C };
-    // 删除指纹 0x0C，删除 flash 数据库中指定 ID 号开始的1 个指纹模板。//PageID: bit 10:11，SUM: bit 14:15
-    uint8_t PS_DeleteBuffer[16]     = { 0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x00, 0x07, 0x0C, '\0', '\0', 0x00, 0x01, '\0', '\0' };
-    // 清空指纹库 0x0D，删除 flash 数据库中所有指纹模板。
-    uint8_t PS_EmptyBuffer[12]      = { 0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x00, 0x03, 0x0D, 0x00, 0x11 };
-    // 读模组参数 0x0F，读取模组的基本参数（波特率，包大小等）。参数表前 16 个字节存放了模组的基本通讯和配置信息，称为模组的基本参数。
-    uint8_t PS_ReadSysParaBuffer[12]      = { 0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x00, 0x03, 0x0F, 0x00, 0x13 };
-    // 读有效模板个数 0x1D，读有效模板个数。
-    uint8_t PS_ValidTempleteNumBuffer[12] = { 0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x00, 0x03, 0x1D, 0x00, 0x21 };
-
-    // 取消指令 0x30，取消自动注册模板和自动验证指纹。加密等级设置为 0 或 1 情况下支持此功能。
-    uint8_t PS_CancelBuffer[12]     = { 0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x00, 0x03, 0x30, 0x00, 0x34 };
-    // 自动注册 0x31，一站式注册指纹，包含采集指纹、生成特征、组合模板、存储模板等功能。加密等级设置为 0 或 1 情况下支持此功能。
-    // 指令说明                                                              标识  长      度  指令   i   d   号  次数   参     数   校     验
-    uint8_t PS_AutoEnrollBuffer[17] = { 0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x00, 0x08, 0x31, '\0', '\0', '\0', 0x00, 0x17, '\0', '\0' };
-    // 自动注册，
-    // 录入次数：1~12，推荐值4~6
-    // 参数说明：最低位为 bit0。
-    //     1) bit0：采图背光灯控制位，0-LED 长亮，1-LED 获取图像成功后灭；
-    //     2) bit1：采图预处理控制位，0-关闭预处理，1-打开预处理；
-    //     3) bit2：注册过程中，是否要求模组在关键步骤，返回当前状态，0-要求返回，1-不要求返回；
-    //     4) bit3：是否允许覆盖 ID 号，0-不允许，1-允许；
-    //     5) bit4：允许指纹重复注册控制位，0-允许，1-不允许；
-    //     6) bit5：注册时，多次指纹采集过程中，是否要求手指离开才能进入下一次指纹图 像采集， 0-要求离开；1-不要求离开；
-    //     7) bit6~bit15：预留。
-    // 当前值为 0x17，0001 0111；灯光获取成功后熄灭，打开预处理，不要求返回状态，不允许覆盖ID，不允许重复注册，多次采集手指需要离开
-
-
-    // 校验和预处理
-    uint8_t PS_AutoEnrollBuffer_Check = PS_AutoEnrollBuffer[6] +PS_AutoEnrollBuffer[7] +PS_AutoEnrollBuffer[8] +PS_AutoEnrollBuffer[9] +
-    PS_AutoEnrollBuffer[12] +PS_AutoEnrollBuffer[13] +PS_AutoEnrollBuffer[14];
-
-    // 休眠指令 0x33，设置传感器进入休眠模式。
-    uint8_t PS_SleepBuffer[12]      = { 0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x00, 0x03, 0x33, 0x00, 0x37 };
-    // LED控制灯指令  0x3C，控制灯指令主要分为两类：一般指示灯和七彩编程呼吸灯。
-    
-    // 指令说明
-    // 功能码：LED 灯模式控制位，1-普通呼吸灯，2-闪烁灯，3-常开灯，4-常闭灯，5-渐开灯，6-渐闭灯，其他功能码不适用于此指令包格式；
-    // 起始颜色：设置为普通呼吸灯时，由灭到亮的颜色，只限于普通呼吸灯（功能码 01）功能，其他功能时，与结束颜色保持一致。
-    //      其中，bit0 是蓝灯控制位；bit1 是绿灯控制位；bit2 是红灯控制位。置 1 灯亮，置 0 灯灭。
-    //      例如 0x01_蓝灯亮，0x02_绿灯亮，0x04_红灯亮，0x06_红绿灯亮，0x05_红蓝灯亮，0x03_绿蓝灯亮，0x07_红绿蓝灯亮，0x00_全灭；
-    // 结束颜色：设置为普通呼吸灯时，由亮到灭的颜色，只限于普通呼吸灯（功能码 0x01），其他功能时，与起始颜色保持一致。设置方式与起始颜色一样；
-    // 循环次数：表示呼吸或者闪烁灯的次数。当设为 0 时，表示无限循环，当设为其他值时，
-    // 表示呼吸有限次数。循环次数适用于呼吸、闪烁功能，其他功能中无效，例如在常开、常闭、渐开和渐闭中是无效的；
-    // 指令说明                                                                  标识  长      度   指令  功能   起始  结束  循环   校     验
-    uint8_t PS_COLORLEDBuffer[16]       = { 0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x00, 0x07, 0x3C, 0x01, 0x02, 0x01, 0x02, 0x00, 0x4A }; // 呼吸灯 绿到蓝色
-    uint8_t PS_BlueLEDBuffer[16]        = { 0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x00, 0x07, 0x3C, 0x03, 0x01, 0x01, 0x00, 0x00, 0x49 }; // 常开 蓝色
-    uint8_t PS_RGLEDBlinkBuffer[16]     = { 0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x00, 0x07, 0x3C, 0x02, 0x06, 0x06, 0x01, 0x00, 0x53 }; // 闪烁1次 红绿色
-    uint8_t PS_RedLEDBuffer[16]         = { 0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x00, 0x07, 0x3C, 0x02, 0x04, 0x04, 0x02, 0x00, 0x50 }; // 闪烁2次 红色
-    uint8_t PS_RedLEDLOOPBuffer[16]     = { 0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x00, 0x07, 0x3C, 0x02, 0x04, 0x04, 0x00, 0x00, 0x4E }; // 循环闪烁闪烁 红色
-    uint8_t PS_GreenLEDBuffer[16]       = { 0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x00, 0x07, 0x3C, 0x02, 0x02, 0x02, 0x02, 0x00, 0x4C }; // 闪烁2次 绿色
-
-    uint8_t PS_OFFLEDBuffer[16]         = { 0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x00, 0x07, 0x3C, 0x04, 0x00, 0x00, 0x00, 0x00, 0x48 }; // 全灭
-
-    uint8_t PS_CustomLEDBuffer[16]      = { 0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x00, 0x07, 0x3C, '\0', '\0', '\0', '\0', '\0', '\0' }; // 自由控制LED
+    friend class FPM383Replay;      // 主机端回放工具直接驱动帧解析器
+
+    uint8_t PS_ReceiveBuffer[FPM383_RECEIVE_SIZE];  //串口接收数据的临时缓冲数组
+    uint8_t _rxIndex;       // 当前帧包头已接收字节数，等于 FPM383_HEADER_SIZE 时包头接收完成
+    uint16_t _rxCount;      // 当前帧包头之后已接收字节数
+    bool _rxStream;         // 当前帧为数据包，载荷直接交给接收端
+    bool _sinkActive;       // 正在接收多包数据
+    uint32_t _transferBytes;        // 最近一次多包上传的字节数
+    uint32_t _transferMicros;       // 最近一次多包上传的耗时（us）
+    uint16_t _rxLength;     // 当前帧包长度字段（确认码+参数+校验和）
+    uint16_t _rxSum;        // 当前帧累计校验和（包标识 ~ 最后一个参数）
+    uint8_t _rxReplay;      // 重新同步后待重新解析的字节在接收缓冲区中的位置，先于串口读取
+    uint8_t _rxReplayEnd;
+
+    // 异步操作状态
+    uint8_t _asyncOp;               // 当前操作类型 FPM383_OP_*
+    uint8_t _asyncStep;             // 当前步骤，等待对应指令的应答包
+    uint8_t _asyncResult;           // 最近一次完成的操作结果
+    uint16_t _asyncScore;           // 最近一次识别成功的比对得分
+    bool _asyncNoFingerLED;         // 识别时无手指是否闪灯
+    uint16_t _searchStart;          // 识别时搜索的起始ID
+    uint16_t _searchCount;          // 识别时搜索的ID个数，FPM383_SEARCH_ALL 为起始ID之后全部
+    uint16_t _asyncTimeout;         // 当前步骤超时时间（ms）
+    unsigned long _asyncStart;      // 当前步骤开始时间
+    uint8_t _asyncNext;             // STEP_ACKS：流水线指令应答处理完后发送该步骤的指令
+    uint16_t _asyncNextTimeout;
+    uint8_t _asyncNextParams;
+    uint8_t _autoSecurity;          // 自动验证参数，发送自动验证指令时使用
+    uint16_t _autoPageID;
+    FPM383Callback _callback;       // 完成回调，可为NULL
+    FPM383ProgressCallback _progress;   // 自动注册进度回调，非NULL时开启状态返回
+
+    uint32_t _baud;                 // 当前主机与模组通信波特率
+    uint16_t _packetSize;           // 数据包载荷大小（字节）
+    uint16_t _capacity;             // 指纹库容量
+    uint8_t _securityLevel;         // 模组安全等级
+    bool _sysParaValid;             // 以上参数已从模组读取
+
+    // 指纹库占用位图，bit(id) 为1表示该ID已注册
+    uint8_t _index[(FPM383_MAX_IDS + 7) / 8];
+    bool _indexValid;               // 位图已从模组读取且覆盖整个指纹库
+
+    // 流水线指令：LED 等不需要结果的指令发送后不等待应答，之后收到时计数丢弃
+    uint8_t _pendingAcks;           // 未读的应答数
+    unsigned long _ackSent;         // 最近一条流水线指令的发送时间
+    uint32_t _acksLost;             // 超时未到达的应答数
+    uint8_t _expectParams;          // 当前等待的成功应答的参数字节数，0 不检查；长度不符的成功应答为迟到的其他指令应答
+
+    uint8_t _lastError;             // FPM383_ERROR_*
+    bool _rxError;                  // 本次等待中出现过校验和错误或包长度非法
+    bool _rxAny;                    // 本次等待中收到过字节
+
+#if FPM383_STATS
+    FPM383Stats _stats;
+    FPM383OpStats *_statOp;         // 当前（最近一次）指令的统计项
+    unsigned long _statStart;       // 当前指令发送时间（us）
+    uint32_t _statBytes;            // 当前指令已收发字节数
+    bool _statPending;              // 当前指令尚未计入字节数直方图
+    bool _statReplied;              // 当前指令已收到应答
+    void statBegin(uint8_t opcode);
+    void statReply();
+    void statFlush();
+    static uint8_t histBucket(uint32_t value, uint32_t first);
+#endif
+
+#if FPM383_POWER
+    FPM383PowerStats _power;
+    unsigned long _powerSince;      // 上次累计唤醒/休眠时间的时刻（ms）
+    bool _powerAsleep;              // 模组已休眠
+    bool _powerFinger;              // 当前识别操作检测到了手指
+    bool _powerNewEvent;            // 下一次检测到手指为新的手指事件
+    void powerSent(uint16_t bytes, bool command);
+    void powerSleep(bool asleep);
+    void powerUpdate();
+#endif
+
+    // 触摸唤醒
+    int _touchPin;                  // TOUCHOUT 引脚，-1 未使用
+    volatile bool _touched;         // 检测到上升沿（手指按下）
+    bool _touchInterrupt;           // 使用外部中断；否则在 poll() 中查询电平
+    uint8_t _touchLevel;            // 查询模式下上次读取的电平
+    bool _touchMode;                // 低功耗识别模式
+    bool _touchAsleep;              // 模组已休眠，等待触摸
+    bool _touchNoFingerLED;
+    uint8_t _touchSecurity;
+    bool _touchSleepFailed;         // 低功耗识别模式最近一次休眠未成功（确认码非0或无应答）
+    unsigned long _touchSleepAt;    // 最近一次发送休眠指令的时刻（ms）
+#if !defined(ESP32)
+    static YFROBOTFPM383 *_touchSlots[FPM383_TOUCH_MAX];   // 中断函数无参数，经此表转发到对应模组
+    template <uint8_t N> static void touchTrampoline() { touchISR(_touchSlots[N]); }
+#endif
+    static void touchISR(void *arg);
+    void touchSample();
+
+    // 注册参数，异步注册发送自动注册指令时使用
+    uint16_t _enrollID;
+    uint8_t _enrollCount;
+    bool _enrollStatus;             // 本次自动注册开启了关键步骤状态返回
+    uint8_t _enrollReply[3];        // autoEnroll() 应答：确认码 参数1 参数2
+
+    // 指令集见 yfrobot_fpm383.cpp，命令包由 FPM383Packet 在编译期生成并存放于 flash，不占用 RAM
     // 更多指令集请参见：http://file.yfrobot.com.cn/datasheet/FPM383C%E6%A8%A1%E7%BB%84%E9%80%9A%E4%BF%A1%E5%8D%8F%E8%AE%AE_V1.2.pdf
 
-    void sendData(int len, uint8_t PS_Databuffer[]);
-    void receiveData(uint16_t Timeout);
-    String HexToString(uint8_t* data, uint8_t length);
+    FPM383Transport *_owned;        // 构造函数创建的传输接口，析构时释放
+
+    void init();
+    void sendData(const uint8_t *data, size_t len);
+    void serviceInput();
+    void drainAcks();
+    void pipelined();
+    bool consumeAck();
+    void sendPacket(uint8_t pid, const uint8_t *payload, uint16_t len, bool pipeline = false);
+    void sendPacket_P(const uint8_t *packet, uint8_t size, bool pipeline = false);
+    void sendAutoEnroll();
+    uint16_t searchCount(uint16_t start, uint16_t count);
+    void sendSearch(uint16_t start, uint16_t count);
+    void resetReceive();
+    uint8_t feedByte(uint8_t data);
+    uint8_t feedPayload(uint8_t data);
+    bool receiveDataPackets(FPM383DataSink &sink, uint16_t Timeout);
+    bool sendDataPackets(FPM383DataSource &source);
+    uint8_t command(const uint8_t *cmd, uint8_t len, uint16_t Timeout);
+    void markIndex(uint16_t id, bool enrolled);
+    uint8_t resync(uint8_t count);
+    uint8_t readByte();
+    bool rxAvailable();
+    void receiveFailed();
+    bool receiveData(uint16_t Timeout);
+    uint8_t receiveResponse(FPM383Response &response, uint16_t Timeout, uint8_t params = 0);
+    void fillResponse(FPM383Response &response, bool received);
+    bool probe();
+    uint8_t writeReg(uint8_t reg, uint8_t value);
+    bool checkRange(uint16_t start, uint32_t count, FPM383Response &response);
+    bool outOfRange(uint16_t id);
+    uint8_t enrollResult(uint8_t code, uint8_t param1, uint8_t param2);
+    bool enrollFinal(uint8_t code, uint8_t param1);
+    void asyncWait(uint8_t step, uint16_t Timeout, uint8_t params = 0);
+    void asyncSend(uint8_t step, uint16_t Timeout, uint8_t params = 0);
+    void asyncCommand(uint8_t step);
+    void asyncStep();
+    void asyncFinish(uint8_t result);
 
   public:
     // -----------------------------------------------------------------------------
     // Constructor - YFROBOTFPM383
     // -----------------------------------------------------------------------------
-    // YFROBOTFPM383(SERIAL_CLASS *serial, int rxPin, int txPin);
-    YFROBOTFPM383(int rxPin, int txPin);
-    SERIAL_CLASS *_ss;
-    // SoftwareSerial *_ss;
+#if defined(__AVR__) || defined(ESP32)
+    YFROBOTFPM383(int rxPin, int txPin);    // AVR：软件串口；ESP32：硬件串口2
+    YFROBOTFPM383(HardwareSerial &serial, int rxPin = -1, int txPin = -1);   // 指定硬件串口，引脚仅 ESP32 有效
+#endif
+    YFROBOTFPM383(Stream &stream);              // 任意 Stream，波特率（57600，8N2）由调用者设置
+    YFROBOTFPM383(FPM383Transport *transport);  // 自定义传输接口，波特率需已设置为模组波特率
+    ~YFROBOTFPM383();
+    FPM383Transport *_ss;
     int _pin_rx;			//RX pin
     int _pin_tx;			//TX pin
 
-    bool begin();
+    bool begin(uint32_t baud = 0);
+    bool setBaudRate(uint32_t baud);
+    uint32_t baudRate();
+    // 模组基本参数：begin() 读取一次并缓存，用于ID范围检查、搜索范围及数据包大小
+    bool readSysPara();
+    uint16_t capacity();
+    uint8_t securityLevel();
+    uint16_t packetSize();
+    bool setPacketSize(uint16_t size);
     String getChipSN();
+    bool getChipSN(char *sn, size_t size);
     void sleep();
     void controlLED(uint8_t PS_ControlLEDBuffer[]);
     void controlLEDC( uint8_t fun, uint8_t start, uint8_t end, uint8_t cycle );
@@ -125,15 +400,97 @@ class YFROBOTFPM383
     uint8_t getImage();
     uint8_t getChar();
     uint8_t searchMB();
+    uint8_t searchMB(uint16_t *PageID, uint16_t *score);
+    uint8_t searchMB(uint16_t start, uint16_t count, uint16_t *PageID = NULL, uint16_t *score = NULL);
+    uint8_t match(uint16_t *score);
     uint8_t empty();
     uint8_t * autoEnroll(uint16_t PageID, uint8_t entriesCount);
     uint8_t deleteID(uint16_t PageID);
+    uint8_t deleteRange(uint16_t start, uint16_t count);
     uint8_t enroll(uint16_t PageID, uint8_t entriesCount);
-    uint8_t identify(bool NoFingerLED);
+    uint8_t identify(bool NoFingerLED, uint16_t start = 0, uint16_t count = FPM383_SEARCH_ALL);
+    uint8_t autoIdentify(bool NoFingerLED, uint8_t securityLevel = FPM383_SECURITY_DEFAULT,
+                         uint16_t PageID = FPM383_SEARCH_ALL, uint16_t Timeout = 5000);
     // uint8_t getSearchID(uint8_t ACK);
     // void ENROLL_ACK_CHECK(uint8_t ACK);
     uint8_t inquiry(); // 查询已注册数量
 
+    // 应答结构体接口：不分配内存，结果写入调用者提供的 response，返回确认码；上面的同名函数均由此实现
+    uint8_t request(const uint8_t *cmd, uint8_t len, FPM383Response &response, uint16_t Timeout = 2000);
+    uint8_t readSysPara(FPM383Response &response);
+    uint8_t cancel(FPM383Response &response);
+    uint8_t getImage(FPM383Response &response);
+    uint8_t getChar(FPM383Response &response);
+    uint8_t searchMB(FPM383Response &response);
+    uint8_t searchMB(uint16_t start, uint16_t count, FPM383Response &response);
+    uint8_t match(FPM383Response &response);
+    uint8_t empty(FPM383Response &response);
+    uint8_t autoEnroll(uint16_t PageID, uint8_t entriesCount, FPM383Response &response);
+    uint8_t deleteID(uint16_t PageID, FPM383Response &response);
+    uint8_t deleteRange(uint16_t start, uint16_t count, FPM383Response &response);
+    uint8_t inquiry(FPM383Response &response);
+    uint8_t loadChar(uint8_t bufferID, uint16_t PageID, FPM383Response &response);
+    uint8_t storeChar(uint8_t bufferID, uint16_t PageID, FPM383Response &response);
+
+    // 模板传输：bufferID 为模组特征缓冲区号（1 或 2）
+    uint8_t loadChar(uint8_t bufferID, uint16_t PageID);
+    uint8_t storeChar(uint8_t bufferID, uint16_t PageID);
+    uint8_t upChar(uint8_t bufferID, FPM383DataSink &sink);
+    uint8_t downChar(uint8_t bufferID, FPM383DataSource &source);
+    uint8_t uploadTemplate(uint16_t PageID, FPM383DataSink &sink);
+    uint8_t uploadTemplate(uint16_t PageID, uint8_t *buffer, uint32_t capacity, uint32_t *length);
+    uint8_t downloadTemplate(uint16_t PageID, FPM383DataSource &source);
+    uint8_t downloadTemplate(uint16_t PageID, const uint8_t *buffer, uint32_t length);
+
+    // 图像上传：getImage() 采集的原始图像（FPM383_IMAGE_SIZE 字节），数据包到达时直接写入接收端
+    uint8_t upImage(FPM383DataSink &sink);
+    uint8_t upImage(uint8_t *buffer, uint32_t capacity, uint32_t *length);
+    uint8_t upImage(FPM383RingBuffer &ring);
+    uint32_t transferRate();        // 最近一次多包上传的速率（字节/秒）
+
+    // 指纹库占用索引：loadIndex() 读取一次后，注册、删除、清空时自动更新，查询无需再与模组通信
+    bool loadIndex();
+    bool indexValid();
+    bool isEnrolled(uint16_t PageID);
+    uint16_t nextFreeId(uint16_t from = 0);
+    uint16_t nextEnrolled(uint16_t from = 0);
+    uint16_t enrolledCount();
+
+    // 异步（非阻塞）操作：begin*() 发送首条指令后立即返回，循环调用 poll() 推进
+    bool beginIdentify(bool NoFingerLED, uint16_t start = 0, uint16_t count = FPM383_SEARCH_ALL);
+    bool beginEnroll(uint16_t PageID, uint8_t entriesCount);
+    bool beginAutoIdentify(bool NoFingerLED, uint8_t securityLevel = FPM383_SECURITY_DEFAULT,
+                           uint16_t PageID = FPM383_SEARCH_ALL, uint16_t Timeout = 5000);
+    uint8_t poll();
+    bool busy();
+    uint8_t result();
+    uint16_t score();
+    void onComplete(FPM383Callback callback);
+    void onEnrollProgress(FPM383ProgressCallback callback);
+    bool abort();
+
+    // 触摸唤醒低功耗识别：模组休眠等待触摸，TOUCHOUT 上升沿触发自动验证，完成后再次休眠
+    bool touchBegin(int touchPin);
+    void touchEnd();
+    bool touched();
+    bool beginSleep();
+    bool beginTouchIdentify(bool NoFingerLED, uint8_t securityLevel = FPM383_SECURITY_DEFAULT);
+    void endTouchIdentify();
+
+    // 通信诊断
+    uint8_t lastError();
+    uint8_t pendingAcks();          // 已发送但应答尚未到达的流水线指令数
+    uint32_t acksLost();
+#if FPM383_STATS
+    const FPM383Stats &stats();
+    const FPM383OpStats *opStats(uint8_t opcode);
+    void resetStats();
+#endif
+#if FPM383_POWER
+    const FPM383PowerStats &powerStats();
+    void resetPowerStats();
+#endif
+
 };
 
 #endif // YFROBOTFPM383_H